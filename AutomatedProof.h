@@ -7,31 +7,49 @@
 #include <set>
 #include <iostream>
 #include <limits>
+#include <unordered_map>
 #include "BaseClasses.h"
+#include "Trace.h"
 using namespace std;
 
 // Automated Proof & Verification
 class ProofSystem {
 private:
     vector<string> steps;
+    TraceSink* trace = &consoleTrace();
 
 public:
-    void addStep(const string& step) { steps.push_back(step); }
+    void setTraceSink(TraceSink& sink) { trace = &sink; }
+
+    // Steps are only kept when the sink will show the full proof
+    bool recording() const { return trace->wants(TraceLevel::Proof); }
+
+    void addStep(const string& step) {
+        if (recording()) steps.push_back(step);
+    }
     void reset() { steps.clear(); }
 
     void displayProof(const string& theorem) {
-        cout << endl;
-        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
-        cout << "           FORMAL PROOF VERIFICATION"<<endl;
-        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
-        cout << endl<<endl;
-        cout << "Theorem : " << theorem << endl;
-        cout << string(60, '-') << endl;
-        for (size_t i = 0; i < steps.size(); i++) {
-            cout << "Step " << (i + 1) << ": " << steps[i] << endl;
+        if (!trace->wants(TraceLevel::Summary)) return;
+        ostream& out = trace->stream();
+
+        if (recording()) {
+            out << "\n";
+            out << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << "\n";
+            out << "           FORMAL PROOF VERIFICATION" << "\n";
+            out << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << "\n";
+            out << "\n\n";
+        }
+        out << "Theorem : " << theorem << "\n";
+        if (recording()) {
+            out << string(60, '-') << "\n";
+            for (size_t i = 0; i < steps.size(); i++) {
+                out << "Step " << (i + 1) << ": " << steps[i] << "\n";
+            }
+            out << string(60, '-') << "\n";
         }
-        cout << string(60, '-') << endl;
-        cout << "[SUCCESS] Q.E.D. (Quod Erat Demonstrandum) "<<endl;
+        out << "[SUCCESS] Q.E.D. (Quod Erat Demonstrandum) " << "\n";
+        trace->flush();
     }
 
     // MATHEMATICAL INDUCTION PROOF 
@@ -60,30 +78,33 @@ public:
     }
 
     // PROOF OF COURSE PREREQUISITE CHAIN
-    void proveCourseChain(const vector<string>& courses,
+    bool proveCourseChain(const vector<string>& courses,
         const map<string, set<string>>& prerequisites) {
+        bool narrate = recording();
         reset();
         addStep("PROOF: Valid Course Sequence by Induction");
         addStep("");
 
-        string sequence = "Course sequence: ";
-        for (const auto& c : courses) sequence += c + " -> ";
-        sequence += "END";
-        addStep(sequence);
-        addStep("");
+        if (narrate) {
+            string sequence = "Course sequence: ";
+            for (const auto& c : courses) sequence += c + " -> ";
+            sequence += "END";
+            addStep(sequence);
+            addStep("");
+        }
 
         // Base case
-        addStep("BASE CASE (n=1): First course " + courses[0]);
+        if (narrate) addStep("BASE CASE (n=1): First course " + courses[0]);
 
         auto it = prerequisites.find(courses[0]);
         if (it != prerequisites.end() && !it->second.empty()) {
             addStep("  [ERROR] First course has prerequisites!");
             displayProof("Invalid Course Sequence");
-            return;
+            return false;
         }
 
         addStep("  Prerequisites: None");
-        addStep("  [SUCCESS] Student can take " + courses[0]);
+        if (narrate) addStep("  [SUCCESS] Student can take " + courses[0]);
         addStep("");
 
         // Inductive step
@@ -92,30 +113,34 @@ public:
         addStep("");
         addStep("INDUCTIVE STEP:");
 
+        // First position of every course seen so far
+        unordered_map<string, size_t> position;
+        position.emplace(courses[0], 0);
+
         bool valid = true;
         for (size_t i = 1; i < courses.size(); i++) {
-            addStep("");
-            addStep("Course at position " + to_string(i + 1) + ": " + courses[i]);
+            if (narrate) {
+                addStep("");
+                addStep("Course at position " + to_string(i + 1) + ": " + courses[i]);
+            }
 
             auto prereqIt = prerequisites.find(courses[i]);
             if (prereqIt != prerequisites.end() && !prereqIt->second.empty()) {
-                string prereqStr = "  Prerequisites: { ";
-                for (const auto& p : prereqIt->second) prereqStr += p + " ";
-                prereqStr += "}";
-                addStep(prereqStr);
+                if (narrate) {
+                    string prereqStr = "  Prerequisites: { ";
+                    for (const auto& p : prereqIt->second) prereqStr += p + " ";
+                    prereqStr += "}";
+                    addStep(prereqStr);
+                }
 
                 // Check if all prereqs are before this
                 for (const auto& prereq : prereqIt->second) {
-                    bool found = false;
-                    for (size_t j = 0; j < i; j++) {
-                        if (courses[j] == prereq) {
-                            found = true;
-                            addStep("    [SUCCESS] " + prereq + " at position " + to_string(j + 1));
-                            break;
-                        }
+                    auto at = position.find(prereq);
+                    if (at != position.end()) {
+                        if (narrate) addStep("    [SUCCESS] " + prereq + " at position " + to_string(at->second + 1));
                     }
-                    if (!found) {
-                        addStep("    [ERROR] " + prereq + " NOT satisfied!");
+                    else {
+                        if (narrate) addStep("    [ERROR] " + prereq + " NOT satisfied!");
                         valid = false;
                     }
                 }
@@ -128,6 +153,7 @@ public:
                 addStep("  Prerequisites: None");
                 addStep("  [SUCCESS] Can be taken at any time");
             }
+            position.emplace(courses[i], i);
         }
 
         addStep("");
@@ -142,6 +168,7 @@ public:
         }
 
         displayProof(valid ? "Valid Course Sequence" : "Invalid Course Sequence");
+        return valid;
     }
 
    // PROOF BY STRONG INDUCTION 
@@ -5,6 +5,7 @@
 #include <vector>
 #include <set>
 #include <iostream>
+#include <functional>
 using namespace std;
 
 // Base entity classes used in all other modules
@@ -193,4 +194,26 @@ public:
     }
 };
 
+// Enrollment Events
+// The enrollment paths of the data store publish here. Modules that keep
+// state derived from enrollments (enrollment sketches) subscribe once and
+// stay current instead of rescanning rosters. Student objects made for
+// demonstrations do not publish.
+class EnrollmentEvents {
+public:
+    using Listener = function<void(const string& student, const string& course)>;
+
+    static void subscribe(Listener listener) { listeners().push_back(move(listener)); }
+
+    static void enrolled(const string& student, const string& course) {
+        for (const auto& l : listeners()) l(student, course);
+    }
+
+private:
+    static vector<Listener>& listeners() {
+        static vector<Listener> all;
+        return all;
+    }
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,137 @@
+#ifndef BIT_RELATION_H
+#define BIT_RELATION_H
+
+#include <vector>
+#include <cstdint>
+#include "Bits.h"
+using namespace std;
+
+// Bit-Matrix Relation
+// A relation over elements 0 .. n-1 as an n x n bit matrix: row i holds bit
+// j when (i, j) is related, packed 64 columns to a word. Property checks and
+// closure work a row at a time, 64 pairs per word operation:
+//   - transitive: R o R is contained in R, i.e. row k is inside row i for
+//     every k in row i, O(|R| * n / 64)
+//   - symmetric: R equals its transpose, built from 64 x 64 block transposes
+//   - closure (Warshall): for every k, each row holding k absorbs row k,
+//     O(n^3 / 64)
+class BitRelation {
+private:
+    size_t n;
+    size_t stride;                      // words per row
+    vector<uint64_t> bits;
+
+    uint64_t* row(size_t i) { return bits.data() + i * stride; }
+    const uint64_t* row(size_t i) const { return bits.data() + i * stride; }
+
+    // Transposes a 64 x 64 bit block in place (bit c of word r <-> bit r of word c)
+    static void transpose64(uint64_t a[64]) {
+        uint64_t m = 0x00000000FFFFFFFFULL;
+        for (size_t j = 32; j != 0; j >>= 1, m ^= m << j) {
+            for (size_t k = 0; k < 64; k = (k + j + 1) & ~j) {
+                uint64_t t = ((a[k] >> j) ^ a[k + j]) & m;
+                a[k] ^= t << j;
+                a[k + j] ^= t;
+            }
+        }
+    }
+
+public:
+    explicit BitRelation(size_t size = 0) : n(size), stride((size + 63) / 64), bits(size * ((size + 63) / 64), 0) {}
+
+    size_t size() const { return n; }
+
+    void add(size_t i, size_t j) { row(i)[j / 64] |= 1ULL << (j % 64); }
+    bool has(size_t i, size_t j) const { return row(i)[j / 64] >> (j % 64) & 1; }
+
+    size_t count() const {
+        size_t total = 0;
+        for (uint64_t w : bits) total += (size_t)popcount64(w);
+        return total;
+    }
+
+    // Visits the pairs row by row, columns ascending
+    template <typename Fn>
+    void forEachPair(Fn fn) const {
+        for (size_t i = 0; i < n; i++) {
+            const uint64_t* r = row(i);
+            for (size_t w = 0; w < stride; w++) {
+                for (uint64_t rest = r[w]; rest; rest &= rest - 1) fn(i, w * 64 + (size_t)ctz64(rest));
+            }
+        }
+    }
+
+    bool isReflexive() const {
+        for (size_t i = 0; i < n; i++) {
+            if (!has(i, i)) return false;
+        }
+        return true;
+    }
+
+    BitRelation transpose() const {
+        BitRelation out(n);
+        uint64_t block[64];
+        for (size_t bi = 0; bi < stride; bi++) {
+            for (size_t bj = 0; bj < stride; bj++) {
+                for (size_t r = 0; r < 64; r++) block[r] = bi * 64 + r < n ? row(bi * 64 + r)[bj] : 0;
+                transpose64(block);
+                for (size_t c = 0; c < 64 && bj * 64 + c < n; c++) out.row(bj * 64 + c)[bi] = block[c];
+            }
+        }
+        return out;
+    }
+
+    bool isSymmetric() const { return bits == transpose().bits; }
+
+    bool isTransitive() const {
+        for (size_t i = 0; i < n; i++) {
+            const uint64_t* ri = row(i);
+            for (size_t w = 0; w < stride; w++) {
+                for (uint64_t rest = ri[w]; rest; rest &= rest - 1) {
+                    const uint64_t* rk = row(w * 64 + (size_t)ctz64(rest));
+                    for (size_t x = 0; x < stride; x++) {
+                        if (rk[x] & ~ri[x]) return false;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    bool isEquivalence() const { return isReflexive() && isSymmetric() && isTransitive(); }
+
+    // Warshall's algorithm
+    BitRelation transitiveClosure() const {
+        BitRelation out(*this);
+        for (size_t k = 0; k < n; k++) {
+            const uint64_t* rk = out.row(k);
+            uint64_t bit = 1ULL << (k % 64);
+            for (size_t i = 0; i < n; i++) {
+                uint64_t* ri = out.row(i);
+                if (!(ri[k / 64] & bit)) continue;
+                for (size_t x = 0; x < stride; x++) ri[x] |= rk[x];
+            }
+        }
+        return out;
+    }
+
+    // (i, j) when (i, k) in a and (k, j) in b; both over the same n elements
+    static BitRelation compose(const BitRelation& a, const BitRelation& b) {
+        BitRelation out(a.n);
+        for (size_t i = 0; i < a.n; i++) {
+            uint64_t* ro = out.row(i);
+            const uint64_t* ri = a.row(i);
+            for (size_t w = 0; w < a.stride; w++) {
+                for (uint64_t rest = ri[w]; rest; rest &= rest - 1) {
+                    const uint64_t* rk = b.row(w * 64 + (size_t)ctz64(rest));
+                    for (size_t x = 0; x < a.stride; x++) ro[x] |= rk[x];
+                }
+            }
+        }
+        return out;
+    }
+
+    bool operator==(const BitRelation& other) const { return n == other.n && bits == other.bits; }
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef BITS_H
+#define BITS_H
+
+#include <cstdint>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+using namespace std;
+
+// Bit Counting
+// popcount / count trailing zeros / count leading zeros on one word, using
+// the MSVC intrinsics or the GCC/Clang builtins. ctz and clz expect x != 0.
+#if defined(_MSC_VER) && !defined(__clang__)
+inline int popcount64(uint64_t x) {
+#if defined(_M_X64)
+    return (int)__popcnt64(x);
+#else
+    return (int)(__popcnt((uint32_t)x) + __popcnt((uint32_t)(x >> 32)));
+#endif
+}
+
+inline int ctz64(uint64_t x) {
+    unsigned long i;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanForward64(&i, x);
+    return (int)i;
+#else
+    if (_BitScanForward(&i, (uint32_t)x)) return (int)i;
+    _BitScanForward(&i, (uint32_t)(x >> 32));
+    return (int)i + 32;
+#endif
+}
+
+inline int clz64(uint64_t x) {
+    unsigned long i;
+#if defined(_M_X64) || defined(_M_ARM64)
+    _BitScanReverse64(&i, x);
+    return 63 - (int)i;
+#else
+    if (_BitScanReverse(&i, (uint32_t)(x >> 32))) return 31 - (int)i;
+    _BitScanReverse(&i, (uint32_t)x);
+    return 63 - (int)i;
+#endif
+}
+
+inline int popcount32(uint32_t x) { return (int)__popcnt(x); }
+
+inline int ctz32(uint32_t x) {
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return (int)i;
+}
+#else
+inline int popcount64(uint64_t x) { return __builtin_popcountll(x); }
+inline int ctz64(uint64_t x) { return __builtin_ctzll(x); }
+inline int clz64(uint64_t x) { return __builtin_clzll(x); }
+inline int popcount32(uint32_t x) { return __builtin_popcount(x); }
+inline int ctz32(uint32_t x) { return __builtin_ctz(x); }
+#endif
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef CARTESIAN_PRODUCT_H
+#define CARTESIAN_PRODUCT_H
+
+#include <set>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#include <cstdint>
+#include "Parallel.h"
+using namespace std;
+
+// Factor sizes multiplied with an overflow check
+inline uint64_t productSize(const vector<uint64_t>& sizes) {
+    uint64_t total = 1;
+    for (uint64_t s : sizes) {
+        if (s != 0 && total > UINT64_MAX / s) throw runtime_error("Cartesian product size does not fit in 64 bits");
+        total *= s;
+    }
+    return total;
+}
+
+// Cartesian Product
+// A x B as a view: pair i is (A[i / |B|], B[i % |B|]), in the same order a
+// set<pair<A, B>> built from sorted inputs would have. Nothing is stored
+// besides the two factors, so candidate spaces such as student x slot can be
+// scanned, indexed or split across threads without building them.
+template <typename A, typename B>
+class CartesianProduct {
+private:
+    vector<A> left;
+    vector<B> right;
+    uint64_t total;
+
+public:
+    using Pair = pair<const A&, const B&>;
+
+    class const_iterator {
+    private:
+        const CartesianProduct* owner;
+        size_t row, col;
+    public:
+        const_iterator(const CartesianProduct* p, size_t r, size_t c) : owner(p), row(r), col(c) {}
+        Pair operator*() const { return Pair(owner->left[row], owner->right[col]); }
+        const_iterator& operator++() {
+            if (++col == owner->right.size()) {
+                col = 0;
+                row++;
+            }
+            return *this;
+        }
+        bool operator!=(const const_iterator& other) const { return row != other.row || col != other.col; }
+    };
+
+    CartesianProduct(vector<A> a, vector<B> b) : left(move(a)), right(move(b)) {
+        total = productSize({ left.size(), right.size() });
+        if (total == 0) {
+            left.clear();
+            right.clear();
+        }
+    }
+
+    CartesianProduct(const set<A>& a, const set<B>& b)
+        : CartesianProduct(vector<A>(a.begin(), a.end()), vector<B>(b.begin(), b.end())) {}
+
+    uint64_t size() const { return total; }
+    bool empty() const { return total == 0; }
+    const vector<A>& first() const { return left; }
+    const vector<B>& second() const { return right; }
+
+    Pair at(uint64_t i) const { return Pair(left[i / right.size()], right[i % right.size()]); }
+    Pair operator[](uint64_t i) const { return at(i); }
+
+    const_iterator begin() const { return const_iterator(this, 0, 0); }
+    const_iterator end() const { return const_iterator(this, left.size(), 0); }
+
+    // Visits pairs [begin, end) in order; fn(a, b) returns false to stop
+    template <typename Fn>
+    bool forEachInRange(uint64_t begin, uint64_t end, Fn fn) const {
+        if (begin >= end) return true;
+        size_t row = begin / right.size(), col = begin % right.size();
+        for (uint64_t i = begin; i < end; i++) {
+            if (!fn(left[row], right[col])) return false;
+            if (++col == right.size()) {
+                col = 0;
+                row++;
+            }
+        }
+        return true;
+    }
+
+    // One contiguous chunk of pairs per worker; fn(a, b, worker)
+    template <typename Fn>
+    void forEachParallel(Fn fn, unsigned threads = 0, size_t minPerWorker = 4096) const {
+        parallelFor((size_t)total, workerCount((size_t)total, minPerWorker, threads), [&](size_t begin, size_t end, unsigned w) {
+            forEachInRange(begin, end, [&](const A& a, const B& b) { fn(a, b, w); return true; });
+        });
+    }
+
+    set<pair<A, B>> toSet() const {
+        set<pair<A, B>> out;
+        for (const auto& p : *this) out.emplace_hint(out.end(), p.first, p.second);
+        return out;
+    }
+};
+
+// N-ary Product
+// F0 x F1 x ... x Fk-1 over one element type, as a mixed-radix counter: the
+// last factor varies fastest. at(i) costs one division per factor; walking
+// a range steps the counter like an odometer.
+template <typename T>
+class NaryProduct {
+private:
+    vector<vector<T>> factors;
+    uint64_t total;
+
+    // Digits of position i, last factor least significant
+    void digitsOf(uint64_t i, vector<size_t>& digits) const {
+        digits.assign(factors.size(), 0);
+        for (size_t f = factors.size(); f-- > 0;) {
+            digits[f] = (size_t)(i % factors[f].size());
+            i /= factors[f].size();
+        }
+    }
+
+public:
+    explicit NaryProduct(vector<vector<T>> sets) : factors(move(sets)) {
+        vector<uint64_t> sizes;
+        for (const auto& f : factors) sizes.push_back(f.size());
+        total = productSize(sizes);
+    }
+
+    explicit NaryProduct(const vector<set<T>>& sets) : NaryProduct([&]() {
+        vector<vector<T>> v;
+        for (const auto& s : sets) v.emplace_back(s.begin(), s.end());
+        return v;
+    }()) {}
+
+    uint64_t size() const { return total; }
+    size_t arity() const { return factors.size(); }
+    const vector<T>& factor(size_t f) const { return factors[f]; }
+
+    vector<T> at(uint64_t i) const {
+        vector<size_t> digits;
+        digitsOf(i, digits);
+        vector<T> tuple;
+        tuple.reserve(factors.size());
+        for (size_t f = 0; f < factors.size(); f++) tuple.push_back(factors[f][digits[f]]);
+        return tuple;
+    }
+
+    // Visits tuples [begin, end) as index digits: fn(digits) where factor
+    // f's element is factor(f)[digits[f]]; fn returns false to stop
+    template <typename Fn>
+    bool forEachInRange(uint64_t begin, uint64_t end, Fn fn) const {
+        if (begin >= end) return true;
+        vector<size_t> digits;
+        digitsOf(begin, digits);
+        for (uint64_t i = begin; i < end; i++) {
+            if (!fn(digits)) return false;
+            for (size_t f = factors.size(); f-- > 0;) {
+                if (++digits[f] < factors[f].size()) break;
+                digits[f] = 0;
+            }
+        }
+        return true;
+    }
+
+    // One contiguous chunk of tuples per worker; fn(digits, worker)
+    template <typename Fn>
+    void forEachParallel(Fn fn, unsigned threads = 0, size_t minPerWorker = 4096) const {
+        parallelFor((size_t)total, workerCount((size_t)total, minPerWorker, threads), [&](size_t begin, size_t end, unsigned w) {
+            forEachInRange(begin, end, [&](const vector<size_t>& digits) { fn(digits, w); return true; });
+        });
+    }
+};
+
+#endif
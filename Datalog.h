@@ -0,0 +1,513 @@
+#ifndef DATALOG_H
+#define DATALOG_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <iostream>
+#include <stdexcept>
+#include <cstdint>
+#include "BaseClasses.h"
+#include "Interner.h"
+#include "Parallel.h"
+using namespace std;
+
+// Datalog Engine
+// Rules over predicates with variables, e.g.
+//     eligible(S, C) :- completed(S, P), prereq(C, P).
+// Relations are append-only tuple tables with hash indexes on the column sets
+// the rules look up. run() evaluates bottom-up and semi-naively: each round
+// only joins the tuples that are new since the last round (the delta). A rule
+// is planned once per body atom reading the delta; atoms before it read only
+// the old tuples and atoms after it read old and new, so one rule covers
+// every student and each combination of tuples is joined once per run.
+//
+// In rules, arguments starting with an uppercase letter or '_' are variables;
+// other words and "quoted" strings are constants. Facts are always ground.
+class DatalogEngine {
+public:
+    struct Stats {
+        size_t rounds = 0;
+        size_t produced = 0;            // head tuples produced by joins, duplicates included
+        size_t derived = 0;             // of those, new tuples
+    };
+
+private:
+    static constexpr uint32_t none = IdInterner::npos;
+
+    struct Index {
+        vector<uint32_t> columns;
+        unordered_map<uint64_t, vector<uint32_t>> buckets;      // key hash -> rows
+    };
+
+    struct Relation {
+        uint32_t arity = 0;
+        vector<uint32_t> data;          // rows * arity values
+        size_t rows = 0;
+        size_t seen = 0;                // rows already joined by a finished round
+        vector<Index> indexes;          // indexes[0] covers every column (dedup)
+
+        const uint32_t* row(size_t r) const { return data.data() + r * arity; }
+    };
+
+    // How an atom argument is matched against a tuple column
+    enum Action : uint8_t { Const, Bound, Bind, Same };
+
+    struct Term {
+        bool variable;
+        uint32_t id;                    // variable number or constant symbol
+    };
+
+    struct Atom {
+        uint32_t relation;
+        vector<Term> terms;
+    };
+
+    struct Step {
+        uint32_t relation;
+        uint32_t index;                 // into Relation::indexes, or none to scan
+        bool old = false;               // only rows from before this round
+        vector<Action> actions;
+        vector<uint32_t> values;        // per column: constant or variable number
+    };
+
+    // One join order per body atom: that atom reads the delta, earlier atoms
+    // the old rows and later atoms all rows, through indexes on their
+    // already-bound columns
+    struct Plan {
+        uint32_t deltaAtom;
+        vector<Step> steps;
+    };
+
+    struct Rule {
+        Atom head;
+        vector<Atom> body;
+        uint32_t variables;
+        vector<Plan> plans;
+        string text;
+    };
+
+    IdInterner symbols;
+    IdInterner predicates;
+    vector<Relation> relations;
+    vector<Rule> rules;
+
+    static uint64_t mix(uint64_t h, uint32_t v) {
+        h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+        return h;
+    }
+
+    static uint64_t keyOf(const uint32_t* row, const vector<uint32_t>& columns) {
+        uint64_t h = columns.size();
+        for (uint32_t c : columns) h = mix(h, row[c]);
+        return h;
+    }
+
+    uint32_t relation(string_view name, size_t arity) {
+        uint32_t id = predicates.intern(string(name));
+        if (id == relations.size()) {
+            relations.emplace_back();
+            Relation& r = relations.back();
+            r.arity = (uint32_t)arity;
+            r.indexes.emplace_back();
+            for (uint32_t c = 0; c < arity; c++) r.indexes[0].columns.push_back(c);
+        }
+        else if (relations[id].arity != arity) {
+            throw runtime_error("predicate " + string(name) + " used with arity " +
+                to_string(arity) + " and " + to_string(relations[id].arity));
+        }
+        return id;
+    }
+
+    uint32_t indexOn(uint32_t rel, const vector<uint32_t>& columns) {
+        Relation& r = relations[rel];
+        for (uint32_t i = 0; i < r.indexes.size(); i++) {
+            if (r.indexes[i].columns == columns) return i;
+        }
+        Index idx;
+        idx.columns = columns;
+        for (uint32_t row = 0; row < r.rows; row++) {
+            idx.buckets[keyOf(r.row(row), columns)].push_back(row);
+        }
+        r.indexes.push_back(move(idx));
+        return (uint32_t)r.indexes.size() - 1;
+    }
+
+    // Appends the tuple unless it is already present
+    bool insert(uint32_t rel, const uint32_t* tuple) {
+        Relation& r = relations[rel];
+        vector<uint32_t>& bucket = r.indexes[0].buckets[keyOf(tuple, r.indexes[0].columns)];
+        for (uint32_t row : bucket) {
+            if (equal(tuple, tuple + r.arity, r.row(row))) return false;
+        }
+
+        uint32_t row = (uint32_t)r.rows++;
+        r.data.insert(r.data.end(), tuple, tuple + r.arity);
+        bucket.push_back(row);
+        for (size_t i = 1; i < r.indexes.size(); i++) {
+            r.indexes[i].buckets[keyOf(r.row(row), r.indexes[i].columns)].push_back(row);
+        }
+        return true;
+    }
+
+    Step makeStep(const Atom& atom, vector<char>& bound, bool scan) {
+        Step step;
+        step.relation = atom.relation;
+        vector<uint32_t> keyColumns;
+        vector<char> local(bound.size(), 0);
+
+        for (uint32_t c = 0; c < atom.terms.size(); c++) {
+            const Term& t = atom.terms[c];
+            step.values.push_back(t.id);
+            if (!t.variable) {
+                step.actions.push_back(Const);
+                keyColumns.push_back(c);
+            }
+            else if (bound[t.id]) {
+                step.actions.push_back(Bound);
+                keyColumns.push_back(c);
+            }
+            else if (local[t.id]) {
+                step.actions.push_back(Same);
+            }
+            else {
+                step.actions.push_back(Bind);
+                local[t.id] = 1;
+            }
+        }
+        for (size_t v = 0; v < bound.size(); v++) bound[v] |= local[v];
+        step.index = scan || keyColumns.empty() ? none : indexOn(atom.relation, keyColumns);
+        return step;
+    }
+
+    void plan(Rule& rule) {
+        for (uint32_t d = 0; d < rule.body.size(); d++) {
+            Plan p;
+            p.deltaAtom = d;
+            vector<char> bound(rule.variables, 0);
+            // The delta step scans its range, so it never needs an index
+            p.steps.push_back(makeStep(rule.body[d], bound, true));
+            for (uint32_t i = 0; i < rule.body.size(); i++) {
+                if (i == d) continue;
+                p.steps.push_back(makeStep(rule.body[i], bound, false));
+                p.steps.back().old = i < d;
+            }
+            rule.plans.push_back(move(p));
+        }
+    }
+
+    static bool match(const Step& step, const uint32_t* row, vector<uint32_t>& binding) {
+        for (size_t c = 0; c < step.actions.size(); c++) {
+            uint32_t v = step.values[c];
+            switch (step.actions[c]) {
+            case Const: if (row[c] != v) return false; break;
+            case Bound:
+            case Same:  if (row[c] != binding[v]) return false; break;
+            case Bind:  binding[v] = row[c]; break;
+            }
+        }
+        return true;
+    }
+
+    void join(const Rule& rule, const Plan& p, size_t s, vector<uint32_t>& binding,
+        vector<uint32_t>& out) const {
+        if (s == p.steps.size()) {
+            for (const Term& t : rule.head.terms) out.push_back(t.variable ? binding[t.id] : t.id);
+            if (rule.head.terms.empty()) out.push_back(0);      // a propositional head just holds
+            return;
+        }
+
+        const Step& step = p.steps[s];
+        const Relation& r = relations[step.relation];
+        size_t limit = step.old ? r.seen : r.rows;
+        if (step.index == none) {
+            for (size_t row = 0; row < limit; row++) {
+                if (match(step, r.row(row), binding)) join(rule, p, s + 1, binding, out);
+            }
+            return;
+        }
+
+        const Index& idx = r.indexes[step.index];
+        uint64_t h = idx.columns.size();
+        for (uint32_t c : idx.columns) {
+            h = mix(h, step.actions[c] == Const ? step.values[c] : binding[step.values[c]]);
+        }
+        auto it = idx.buckets.find(h);
+        if (it == idx.buckets.end()) return;
+        for (uint32_t row : it->second) {
+            if (row >= limit) break;            // buckets list rows in insertion order
+            if (match(step, r.row(row), binding)) join(rule, p, s + 1, binding, out);
+        }
+    }
+
+    // PARSING
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+    static void skipSpace(string_view text, size_t& pos) {
+        while (pos < text.size() && isSpace(text[pos])) pos++;
+    }
+
+    static string_view word(string_view text, size_t& pos) {
+        skipSpace(text, pos);
+        size_t start = pos;
+        if (pos < text.size() && text[pos] == '"') {
+            size_t close = text.find('"', pos + 1);
+            if (close == string_view::npos) throw runtime_error("unterminated string");
+            pos = close + 1;
+            return text.substr(start, pos - start);
+        }
+        while (pos < text.size() && (isalnum((unsigned char)text[pos]) || text[pos] == '_')) pos++;
+        if (pos == start) throw runtime_error("expected a name at position " + to_string(start));
+        return text.substr(start, pos - start);
+    }
+
+    static void expect(string_view text, size_t& pos, char c) {
+        skipSpace(text, pos);
+        if (pos >= text.size() || text[pos] != c) {
+            throw runtime_error(string("expected '") + c + "' at position " + to_string(pos));
+        }
+        pos++;
+    }
+
+    Atom parseAtom(string_view text, size_t& pos, bool ground,
+        unordered_map<string, uint32_t>& variables) {
+        string_view name = word(text, pos);
+        expect(text, pos, '(');
+
+        vector<Term> terms;
+        skipSpace(text, pos);
+        if (pos < text.size() && text[pos] == ')') {
+            pos++;
+        }
+        else {
+            while (true) {
+                string_view arg = word(text, pos);
+                bool variable = !ground && arg[0] != '"' && (isupper((unsigned char)arg[0]) || arg[0] == '_');
+                if (variable) {
+                    auto it = variables.emplace(string(arg), (uint32_t)variables.size()).first;
+                    terms.push_back({ true, it->second });
+                }
+                else {
+                    if (arg[0] == '"') arg = arg.substr(1, arg.size() - 2);
+                    terms.push_back({ false, symbols.intern(string(arg)) });
+                }
+                skipSpace(text, pos);
+                if (pos < text.size() && text[pos] == ',') {
+                    pos++;
+                    continue;
+                }
+                expect(text, pos, ')');
+                break;
+            }
+        }
+        return { relation(name, terms.size()), terms };
+    }
+
+public:
+    void addFact(const string& predicate, const vector<string>& args) {
+        uint32_t rel = relation(predicate, args.size());
+        vector<uint32_t> tuple;
+        for (const auto& a : args) tuple.push_back(symbols.intern(a));
+        insert(rel, tuple.data());
+    }
+
+    // Parses one fact "p(a, b)." or rule "h(X) :- b1(X, Y), b2(Y).";
+    // throws runtime_error on malformed or unsafe clauses
+    void addClause(const string& text) {
+        size_t pos = 0;
+        unordered_map<string, uint32_t> variables;
+        size_t neck = text.find(":-");
+
+        if (neck == string::npos) {
+            string_view view(text);
+            Atom fact = parseAtom(view, pos, true, variables);
+            skipSpace(view, pos);
+            if (pos < view.size() && view[pos] == '.') pos++;
+            skipSpace(view, pos);
+            if (pos != view.size()) throw runtime_error("unexpected text after fact");
+
+            vector<uint32_t> tuple;
+            for (const Term& t : fact.terms) tuple.push_back(t.id);
+            insert(fact.relation, tuple.data());
+            return;
+        }
+
+        string_view headText = string_view(text).substr(0, neck);
+        string_view bodyText = string_view(text).substr(neck + 2);
+
+        Rule rule;
+        rule.text = text;
+        size_t bpos = 0;
+        while (true) {
+            rule.body.push_back(parseAtom(bodyText, bpos, false, variables));
+            skipSpace(bodyText, bpos);
+            if (bpos < bodyText.size() && bodyText[bpos] == ',') {
+                bpos++;
+                continue;
+            }
+            if (bpos < bodyText.size() && bodyText[bpos] == '.') bpos++;
+            skipSpace(bodyText, bpos);
+            if (bpos != bodyText.size()) throw runtime_error("unexpected text after rule body");
+            break;
+        }
+
+        size_t bodyVariables = variables.size();
+        rule.head = parseAtom(headText, pos, false, variables);
+        skipSpace(headText, pos);
+        if (pos != headText.size()) throw runtime_error("unexpected text in rule head");
+        if (variables.size() != bodyVariables) {
+            throw runtime_error("head variable not bound by the body: " + text);
+        }
+
+        rule.variables = (uint32_t)variables.size();
+        plan(rule);
+        rules.push_back(move(rule));
+
+        // A new rule has to see every existing tuple once
+        for (auto& r : relations) r.seen = 0;
+    }
+
+    // SEMI-NAIVE EVALUATION
+    Stats run(unsigned threads = 0) {
+        Stats stats;
+        vector<size_t> end(relations.size());
+
+        while (true) {
+            bool pending = false;
+            for (size_t i = 0; i < relations.size(); i++) {
+                end[i] = relations[i].rows;
+                pending |= relations[i].seen < end[i];
+            }
+            if (!pending) break;
+            stats.rounds++;
+
+            // Joins only read the relations; new tuples are merged afterwards
+            vector<pair<uint32_t, vector<uint32_t>>> produced;
+            for (const Rule& rule : rules) {
+                for (const Plan& p : rule.plans) {
+                    const Step& first = p.steps[0];
+                    const Relation& r = relations[first.relation];
+                    size_t begin = r.seen, n = end[first.relation] - begin;
+                    if (n == 0) continue;
+
+                    unsigned workers = workerCount(n, 1024, threads);
+                    vector<vector<uint32_t>> out(workers);
+                    parallelFor(n, workers, [&](size_t lo, size_t hi, unsigned w) {
+                        vector<uint32_t> binding(rule.variables);
+                        for (size_t row = begin + lo; row < begin + hi; row++) {
+                            if (match(first, r.row(row), binding)) join(rule, p, 1, binding, out[w]);
+                        }
+                    });
+                    for (auto& o : out) produced.emplace_back(rule.head.relation, move(o));
+                }
+            }
+
+            for (size_t i = 0; i < relations.size(); i++) relations[i].seen = end[i];
+            for (const auto& batch : produced) {
+                uint32_t arity = relations[batch.first].arity;
+                stats.produced += batch.second.size() / max<uint32_t>(arity, 1);
+                if (arity == 0) {
+                    if (!batch.second.empty()) stats.derived += insert(batch.first, nullptr);
+                    continue;
+                }
+                for (size_t k = 0; k < batch.second.size(); k += arity) {
+                    stats.derived += insert(batch.first, batch.second.data() + k);
+                }
+            }
+        }
+        return stats;
+    }
+
+    size_t count(const string& predicate) const {
+        uint32_t id = predicates.find(predicate);
+        return id == none ? 0 : relations[id].rows;
+    }
+
+    bool holds(const string& predicate, const vector<string>& args) const {
+        uint32_t id = predicates.find(predicate);
+        if (id == none || relations[id].arity != args.size()) return false;
+
+        vector<uint32_t> tuple;
+        for (const auto& a : args) {
+            uint32_t s = symbols.find(a);
+            if (s == none) return false;
+            tuple.push_back(s);
+        }
+        const Relation& r = relations[id];
+        auto it = r.indexes[0].buckets.find(keyOf(tuple.data(), r.indexes[0].columns));
+        if (it == r.indexes[0].buckets.end()) return false;
+        for (uint32_t row : it->second) {
+            if (equal(tuple.begin(), tuple.end(), r.row(row))) return true;
+        }
+        return false;
+    }
+
+    vector<vector<string>> tuples(const string& predicate) const {
+        vector<vector<string>> result;
+        uint32_t id = predicates.find(predicate);
+        if (id == none) return result;
+
+        const Relation& r = relations[id];
+        for (size_t row = 0; row < r.rows; row++) {
+            vector<string> t;
+            for (uint32_t c = 0; c < r.arity; c++) t.push_back(symbols.name(r.row(row)[c]));
+            result.push_back(move(t));
+        }
+        return result;
+    }
+
+    // completed(Student, Course) and prereq(Course, Prerequisite) facts
+    void loadUniversity(const vector<Student>& students, const map<string, set<string>>& prerequisites) {
+        for (const auto& s : students) {
+            for (const auto& c : s.getCourses()) addFact("completed", { s.getId(), c });
+        }
+        for (const auto& entry : prerequisites) {
+            for (const auto& p : entry.second) addFact("prereq", { entry.first, p });
+        }
+    }
+
+    static void demonstrate() {
+        cout << endl;
+        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
+        cout << "     DATALOG DEMONSTRATION" << endl;
+        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
+        cout << endl;
+
+        DatalogEngine engine;
+        const char* program[] = {
+            "prereq(CS201, CS101).",
+            "prereq(CS301, CS201).",
+            "prereq(CS302, CS201).",
+            "completed(S1, CS101).",
+            "completed(S2, CS101).",
+            "completed(S2, CS201).",
+            "eligible(S, C) :- completed(S, P), prereq(C, P).",
+            "requires(C, P) :- prereq(C, P).",
+            "requires(C, Q) :- prereq(C, P), requires(P, Q).",
+        };
+        for (const char* clause : program) {
+            cout << "  " << clause << endl;
+            engine.addClause(clause);
+        }
+
+        Stats stats = engine.run();
+        cout << endl;
+        cout << "[SUCCESS] Fixpoint after " << stats.rounds << " rounds, "
+            << stats.derived << " derived tuples" << endl;
+
+        cout << endl;
+        cout << "[INFO] eligible(S, C):" << endl;
+        for (const auto& t : engine.tuples("eligible")) {
+            cout << "  " << t[0] << " may take " << t[1] << endl;
+        }
+        cout << "[INFO] requires(C, P):" << endl;
+        for (const auto& t : engine.tuples("requires")) {
+            cout << "  " << t[0] << " needs " << t[1] << endl;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,195 @@
+#ifndef ELIGIBILITY_H
+#define ELIGIBILITY_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <cstdint>
+#include "BaseClasses.h"
+#include "Interner.h"
+#include "PrerequisiteGraph.h"
+using namespace std;
+
+// Eligibility Tracking
+// Keeps, for every student, the set of courses they can take next. A course
+// is eligible when all of its prerequisites are completed; the tracker counts
+// completed prerequisites per (student, course), so recording a completion
+// only touches the dependents of that course, and the eligible set is kept as
+// a list with O(1) insert/remove, so "what can I take next?" costs O(answer
+// size) no matter how long the history is. Per-student state is sparse: it
+// grows with the student's history and frontier, not with the catalog.
+class EligibilityTracker {
+private:
+    enum Status : uint8_t { Open, Enrolled, Completed };
+
+    struct StudentState {
+        unordered_map<uint32_t, uint16_t> satisfied;    // completed prerequisites, if any
+        unordered_map<uint32_t, uint8_t> status;        // Enrolled / Completed courses only
+        unordered_map<uint32_t, uint32_t> slot;         // index in eligible
+        vector<uint32_t> eligible;                      // course ids, unordered
+    };
+
+    PrerequisiteGraph graph;
+    vector<uint32_t> entryCourses;      // courses without prerequisites
+    IdInterner studentIds;
+    vector<StudentState> states;
+
+    static Status statusOf(const StudentState& s, uint32_t course) {
+        auto it = s.status.find(course);
+        return it == s.status.end() ? Open : (Status)it->second;
+    }
+
+    size_t remaining(const StudentState& s, uint32_t course) const {
+        auto it = s.satisfied.find(course);
+        return graph.prerequisitesOf(course).size() - (it == s.satisfied.end() ? 0 : it->second);
+    }
+
+    void makeEligible(StudentState& s, uint32_t course) {
+        s.slot[course] = (uint32_t)s.eligible.size();
+        s.eligible.push_back(course);
+    }
+
+    void makeIneligible(StudentState& s, uint32_t course) {
+        auto it = s.slot.find(course);
+        if (it == s.slot.end()) return;
+        uint32_t at = it->second;
+        s.slot.erase(it);
+        uint32_t last = s.eligible.back();
+        s.eligible.pop_back();
+        if (last != course) {
+            s.eligible[at] = last;
+            s.slot[last] = at;
+        }
+    }
+
+    StudentState* state(const string& student) {
+        uint32_t id = studentIds.find(student);
+        return id == IdInterner::npos ? nullptr : &states[id];
+    }
+
+    const StudentState* state(const string& student) const {
+        uint32_t id = studentIds.find(student);
+        return id == IdInterner::npos ? nullptr : &states[id];
+    }
+
+public:
+    explicit EligibilityTracker(const PrerequisiteGraph& graph) : graph(graph) {
+        for (uint32_t c = 0; c < graph.size(); c++) {
+            if (graph.prerequisitesOf(c).empty()) entryCourses.push_back(c);
+        }
+    }
+
+    const PrerequisiteGraph& getGraph() const { return graph; }
+    bool hasStudent(const string& student) const { return studentIds.contains(student); }
+
+    // Registers a student with nothing completed; returns false if already known
+    bool addStudent(const string& student) {
+        if (studentIds.contains(student)) return false;
+        studentIds.intern(student);
+
+        states.emplace_back();
+        for (uint32_t c : entryCourses) makeEligible(states.back(), c);
+        return true;
+    }
+
+    // Brings a student's completions in line with their record: courses that
+    // joined it are completed, courses that left it are revoked. Costs
+    // O(record + completed courses), independent of the catalog.
+    void syncStudent(const Student& student) {
+        const string& id = student.getId();
+        addStudent(id);
+        set<string> record = student.getCourses();
+
+        vector<uint32_t> stale;
+        for (const auto& entry : state(id)->status) {
+            if (entry.second == Completed && !record.count(graph.name(entry.first))) stale.push_back(entry.first);
+        }
+        for (uint32_t c : stale) revokeCompletion(id, graph.name(c));
+        for (const auto& c : record) recordCompletion(id, c);
+    }
+
+    // Only the dependents of the completed course are updated
+    bool recordCompletion(const string& student, const string& course) {
+        StudentState* s = state(student);
+        uint32_t c = graph.id(course);
+        if (!s || c == IdInterner::npos || statusOf(*s, c) == Completed) return false;
+
+        s->status[c] = Completed;
+        makeIneligible(*s, c);
+        for (uint32_t d : graph.dependentsOf(c)) {
+            if (++s->satisfied[d] == graph.prerequisitesOf(d).size() && statusOf(*s, d) == Open) makeEligible(*s, d);
+        }
+        return true;
+    }
+
+    // Undoes a completion (the course left the student's record)
+    bool revokeCompletion(const string& student, const string& course) {
+        StudentState* s = state(student);
+        uint32_t c = graph.id(course);
+        if (!s || c == IdInterner::npos || statusOf(*s, c) != Completed) return false;
+
+        s->status.erase(c);
+        for (uint32_t d : graph.dependentsOf(c)) {
+            auto it = s->satisfied.find(d);
+            if (it->second-- == graph.prerequisitesOf(d).size()) makeIneligible(*s, d);
+            if (it->second == 0) s->satisfied.erase(it);
+        }
+        if (remaining(*s, c) == 0) makeEligible(*s, c);
+        return true;
+    }
+
+    // A course the student is currently taking is no longer "next"
+    bool recordEnrollment(const string& student, const string& course) {
+        StudentState* s = state(student);
+        uint32_t c = graph.id(course);
+        if (!s || c == IdInterner::npos || statusOf(*s, c) != Open) return false;
+
+        s->status[c] = Enrolled;
+        makeIneligible(*s, c);
+        return true;
+    }
+
+    bool recordDrop(const string& student, const string& course) {
+        StudentState* s = state(student);
+        uint32_t c = graph.id(course);
+        if (!s || c == IdInterner::npos || statusOf(*s, c) != Enrolled) return false;
+
+        s->status.erase(c);
+        if (remaining(*s, c) == 0) makeEligible(*s, c);
+        return true;
+    }
+
+    bool canTake(const string& student, const string& course) const {
+        const StudentState* s = state(student);
+        uint32_t c = graph.id(course);
+        return s && c != IdInterner::npos && s->slot.count(c) > 0;
+    }
+
+    // Course ids (see getGraph()), in no particular order
+    const vector<uint32_t>& nextCourseIds(const string& student) const {
+        static const vector<uint32_t> none;
+        const StudentState* s = state(student);
+        return s ? s->eligible : none;
+    }
+
+    vector<string> nextCourses(const string& student) const {
+        vector<string> names;
+        for (uint32_t c : nextCourseIds(student)) names.push_back(graph.name(c));
+        return names;
+    }
+};
+
+// Tracker over the prerequisites recorded on a course list
+inline EligibilityTracker eligibilityFor(const vector<Course>& courses) {
+    map<string, set<string>> prerequisites;
+    set<string> ids;
+    for (const auto& c : courses) {
+        ids.insert(c.getId());
+        for (const auto& p : c.getPrerequisites()) prerequisites[c.getId()].insert(p);
+    }
+    return EligibilityTracker(PrerequisiteGraph::build(prerequisites, ids));
+}
+
+#endif
@@ -0,0 +1,354 @@
+#ifndef FLAT_SET_H
+#define FLAT_SET_H
+
+#include <set>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+#include <type_traits>
+#include <cstdint>
+#include "Bits.h"
+#include "Parallel.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLAT_SET_SSE2 1
+#endif
+using namespace std;
+
+// Flat Set
+// A set kept as a sorted, duplicate-free vector. Union, intersection,
+// difference and subset are linear merges over contiguous memory; when one
+// side is much smaller its elements are galloped into the other instead.
+// Intersections of 32-bit integer keys (interned ids) compare four
+// elements against four at a time with SSE2 where available. Several sets
+// at once are intersected or merged in one pass (forEachInAll/forEachInAny).
+// The parallel* operations cut the merge of two large sets into slices of
+// equal length along its merge path and run each slice on its own thread.
+template <typename T>
+class FlatSet {
+private:
+    vector<T> items;
+
+    struct Sorted {};
+    FlatSet(vector<T> sorted, Sorted) : items(move(sorted)) {}
+
+    // First position in [from, n) whose element is not less than x, found
+    // by doubling the step and then binary searching the last gap
+    static size_t gallop(const T* v, size_t from, size_t n, const T& x) {
+        size_t step = 1, lo = from, hi = from;
+        while (hi < n && v[hi] < x) {
+            lo = hi + 1;
+            hi = from + step;
+            step *= 2;
+        }
+        return lower_bound(v + lo, v + min(hi, n), x) - v;
+    }
+
+    static bool skewed(size_t small, size_t large) { return small * 32 < large; }
+
+    static size_t intersectScalar(const T* a, size_t na, const T* b, size_t nb, T* out) {
+        size_t i = 0, j = 0, n = 0;
+        while (i < na && j < nb) {
+            if (a[i] < b[j]) i++;
+            else if (b[j] < a[i]) j++;
+            else {
+                out[n++] = a[i];
+                i++;
+                j++;
+            }
+        }
+        return n;
+    }
+
+    static size_t intersectGalloping(const T* small, size_t ns, const T* large, size_t nl, T* out) {
+        size_t j = 0, n = 0;
+        for (size_t i = 0; i < ns && j < nl; i++) {
+            j = gallop(large, j, nl, small[i]);
+            if (j < nl && !(small[i] < large[j])) out[n++] = small[i];
+        }
+        return n;
+    }
+
+#ifdef FLAT_SET_SSE2
+    // Blocks of four from each side: every element of a's block is compared
+    // with every element of b's block (three rotations), matches are written
+    // out from the lane mask, and the block with the smaller maximum moves on
+    static size_t intersectSSE2(const T* a, size_t na, const T* b, size_t nb, T* out) {
+        size_t i = 0, j = 0, n = 0;
+        while (i + 4 <= na && j + 4 <= nb) {
+            __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+            __m128i vb = _mm_loadu_si128((const __m128i*)(b + j));
+            __m128i hit = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi32(va, vb),
+                    _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+                _mm_or_si128(_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+                    _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+            int mask = _mm_movemask_ps(_mm_castsi128_ps(hit));
+            while (mask) {
+                out[n++] = a[i + ctz32(mask)];
+                mask &= mask - 1;
+            }
+            T lastA = a[i + 3], lastB = b[j + 3];
+            if (!(lastB < lastA)) i += 4;
+            if (!(lastA < lastB)) j += 4;
+        }
+        return n + intersectScalar(a + i, na - i, b + j, nb - j, out + n);
+    }
+#endif
+
+    static size_t intersectRange(const T* a, size_t na, const T* b, size_t nb, T* out) {
+#ifdef FLAT_SET_SSE2
+        if constexpr (is_integral<T>::value && sizeof(T) == 4) return intersectSSE2(a, na, b, nb, out);
+#endif
+        return intersectScalar(a, na, b, nb, out);
+    }
+
+    // Smallest total per worker for the parallel operations
+    static constexpr size_t ParallelMinPerWorker = 1 << 16;
+
+    // Where diagonal d (the first d elements of the merge, ties taken from a
+    // first) crosses the merge path, as (elements of a, elements of b). An
+    // element in both sets is never cut from its twin: the b copy follows a's.
+    static pair<size_t, size_t> mergePathSplit(const FlatSet& a, const FlatSet& b, size_t d) {
+        size_t lo = d > b.size() ? d - b.size() : 0, hi = min(d, a.size());
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (!(b[d - mid - 1] < a[mid])) lo = mid + 1;
+            else hi = mid;
+        }
+        size_t j = d - lo;
+        if (lo > 0 && j < b.size() && !(a[lo - 1] < b[j])) j++;
+        return { lo, j };
+    }
+
+    // Runs op(aBegin, aCount, bBegin, bCount, out) on independent slices and
+    // concatenates their outputs in order
+    template <typename SliceOp>
+    static FlatSet parallelMerge(const FlatSet& a, const FlatSet& b, unsigned workers, SliceOp op) {
+        size_t total = a.size() + b.size();
+        vector<pair<size_t, size_t>> cuts(workers + 1);
+        for (unsigned w = 1; w < workers; w++) cuts[w] = mergePathSplit(a, b, total / workers * w);
+        cuts[0] = { 0, 0 };
+        cuts[workers] = { a.size(), b.size() };
+
+        vector<vector<T>> parts(workers);
+        parallelFor(workers, workers, [&](size_t begin, size_t end, unsigned) {
+            for (size_t s = begin; s < end; s++) {
+                op(a.data() + cuts[s].first, cuts[s + 1].first - cuts[s].first,
+                    b.data() + cuts[s].second, cuts[s + 1].second - cuts[s].second, parts[s]);
+            }
+        });
+
+        vector<size_t> offset(workers + 1, 0);
+        for (unsigned s = 0; s < workers; s++) offset[s + 1] = offset[s] + parts[s].size();
+        vector<T> result(offset[workers]);
+        parallelFor(workers, workers, [&](size_t begin, size_t end, unsigned) {
+            for (size_t s = begin; s < end; s++) move(parts[s].begin(), parts[s].end(), result.begin() + offset[s]);
+        });
+        return FlatSet(move(result), Sorted{});
+    }
+
+public:
+    FlatSet() = default;
+
+    FlatSet(initializer_list<T> values) : FlatSet(vector<T>(values)) {}
+
+    // Sorts and drops duplicates
+    explicit FlatSet(vector<T> values) : items(move(values)) {
+        sort(items.begin(), items.end());
+        items.erase(unique(items.begin(), items.end()), items.end());
+    }
+
+    explicit FlatSet(const set<T>& values) : items(values.begin(), values.end()) {}
+
+    // Takes a vector that is already sorted and duplicate-free
+    static FlatSet fromSorted(vector<T> sorted) { return FlatSet(move(sorted), Sorted{}); }
+
+    size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+    const T* data() const { return items.data(); }
+    const T& operator[](size_t i) const { return items[i]; }
+    typename vector<T>::const_iterator begin() const { return items.begin(); }
+    typename vector<T>::const_iterator end() const { return items.end(); }
+    const vector<T>& values() const { return items; }
+
+    bool contains(const T& x) const { return binary_search(items.begin(), items.end(), x); }
+
+    // O(n) per call; build from a vector when adding many elements
+    bool insert(const T& x) {
+        auto it = lower_bound(items.begin(), items.end(), x);
+        if (it != items.end() && !(x < *it)) return false;
+        items.insert(it, x);
+        return true;
+    }
+
+    bool erase(const T& x) {
+        auto it = lower_bound(items.begin(), items.end(), x);
+        if (it == items.end() || x < *it) return false;
+        items.erase(it);
+        return true;
+    }
+
+    // Sorted input, so each insert is at the end hint
+    set<T> toSet() const { return set<T>(items.begin(), items.end()); }
+
+    bool operator==(const FlatSet& other) const { return items == other.items; }
+    bool operator!=(const FlatSet& other) const { return items != other.items; }
+
+    static FlatSet unionOf(const FlatSet& a, const FlatSet& b) {
+        vector<T> result;
+        result.reserve(a.size() + b.size());
+        set_union(a.items.begin(), a.items.end(), b.items.begin(), b.items.end(), back_inserter(result));
+        return FlatSet(move(result), Sorted{});
+    }
+
+    static FlatSet intersectionOf(const FlatSet& a, const FlatSet& b) {
+        const FlatSet& small = a.size() <= b.size() ? a : b;
+        const FlatSet& large = a.size() <= b.size() ? b : a;
+        vector<T> result(small.size());
+        size_t n;
+        if (skewed(small.size(), large.size())) {
+            n = intersectGalloping(small.data(), small.size(), large.data(), large.size(), result.data());
+        }
+        else {
+            n = intersectRange(a.data(), a.size(), b.data(), b.size(), result.data());
+        }
+        result.resize(n);
+        return FlatSet(move(result), Sorted{});
+    }
+
+    static FlatSet differenceOf(const FlatSet& a, const FlatSet& b) {
+        vector<T> result;
+        if (skewed(b.size(), a.size())) {
+            // Few to remove: copy the runs between them
+            result.reserve(a.size());
+            size_t from = 0;
+            for (const T& x : b.items) {
+                size_t at = gallop(a.data(), from, a.size(), x);
+                result.insert(result.end(), a.items.begin() + from, a.items.begin() + at);
+                from = at < a.size() && !(x < a[at]) ? at + 1 : at;
+            }
+            result.insert(result.end(), a.items.begin() + from, a.items.end());
+        }
+        else {
+            result.reserve(a.size());
+            set_difference(a.items.begin(), a.items.end(), b.items.begin(), b.items.end(), back_inserter(result));
+        }
+        return FlatSet(move(result), Sorted{});
+    }
+
+    // Parallel versions: threads = 0 uses every core; small inputs (under
+    // 64K elements per worker) run the sequential operation instead
+    static FlatSet parallelUnionOf(const FlatSet& a, const FlatSet& b, unsigned threads = 0) {
+        unsigned workers = workerCount(a.size() + b.size(), ParallelMinPerWorker, threads);
+        if (workers == 1) return unionOf(a, b);
+        return parallelMerge(a, b, workers, [](const T* x, size_t nx, const T* y, size_t ny, vector<T>& out) {
+            out.reserve(nx + ny);
+            set_union(x, x + nx, y, y + ny, back_inserter(out));
+        });
+    }
+
+    static FlatSet parallelIntersectionOf(const FlatSet& a, const FlatSet& b, unsigned threads = 0) {
+        unsigned workers = workerCount(a.size() + b.size(), ParallelMinPerWorker, threads);
+        if (workers == 1 || skewed(min(a.size(), b.size()), max(a.size(), b.size()))) return intersectionOf(a, b);
+        return parallelMerge(a, b, workers, [](const T* x, size_t nx, const T* y, size_t ny, vector<T>& out) {
+            out.resize(min(nx, ny));
+            out.resize(intersectRange(x, nx, y, ny, out.data()));
+        });
+    }
+
+    static FlatSet parallelDifferenceOf(const FlatSet& a, const FlatSet& b, unsigned threads = 0) {
+        unsigned workers = workerCount(a.size() + b.size(), ParallelMinPerWorker, threads);
+        if (workers == 1) return differenceOf(a, b);
+        return parallelMerge(a, b, workers, [](const T* x, size_t nx, const T* y, size_t ny, vector<T>& out) {
+            out.reserve(nx);
+            set_difference(x, x + nx, y, y + ny, back_inserter(out));
+        });
+    }
+
+    // Elements in every set, in order, without intermediate sets. Candidates
+    // come from the smallest set; each is galloped into the others, and on a
+    // miss the smallest set gallops ahead to the element that was found, so
+    // the cost follows the smallest set rather than the largest.
+    template <typename Fn>
+    static void forEachInAll(vector<const FlatSet*> sets, Fn fn) {
+        if (sets.empty()) return;
+        sort(sets.begin(), sets.end(), [](const FlatSet* a, const FlatSet* b) { return a->size() < b->size(); });
+        const T* small = sets[0]->data();
+        size_t n = sets[0]->size(), i = 0;
+        vector<size_t> pos(sets.size(), 0);
+
+        while (i < n) {
+            const T& x = small[i];
+            bool inAll = true;
+            for (size_t s = 1; s < sets.size(); s++) {
+                const FlatSet& other = *sets[s];
+                pos[s] = gallop(other.data(), pos[s], other.size(), x);
+                if (pos[s] == other.size()) return;
+                if (x < other[pos[s]]) {
+                    i = gallop(small, i + 1, n, other[pos[s]]);
+                    inAll = false;
+                    break;
+                }
+            }
+            if (inAll) {
+                fn(x);
+                i++;
+            }
+        }
+    }
+
+    // Elements in any set, in order and once each: a heap of set cursors
+    // keyed by their current element
+    template <typename Fn>
+    static void forEachInAny(const vector<const FlatSet*>& sets, Fn fn) {
+        vector<size_t> pos(sets.size(), 0), heap;
+        auto later = [&](size_t a, size_t b) { return (*sets[b])[pos[b]] < (*sets[a])[pos[a]]; };
+        for (size_t s = 0; s < sets.size(); s++) {
+            if (!sets[s]->empty()) heap.push_back(s);
+        }
+        make_heap(heap.begin(), heap.end(), later);
+
+        const T* last = nullptr;
+        while (!heap.empty()) {
+            pop_heap(heap.begin(), heap.end(), later);
+            size_t s = heap.back();
+            const T& x = (*sets[s])[pos[s]];
+            if (!last || *last < x) {
+                fn(x);
+                last = &x;
+            }
+            if (++pos[s] < sets[s]->size()) push_heap(heap.begin(), heap.end(), later);
+            else heap.pop_back();
+        }
+    }
+
+    static FlatSet intersectionOfAll(const vector<const FlatSet*>& sets) {
+        vector<T> result;
+        forEachInAll(sets, [&](const T& x) { result.push_back(x); });
+        return FlatSet(move(result), Sorted{});
+    }
+
+    static FlatSet unionOfAll(const vector<const FlatSet*>& sets) {
+        vector<T> result;
+        forEachInAny(sets, [&](const T& x) { result.push_back(x); });
+        return FlatSet(move(result), Sorted{});
+    }
+
+    // a is a subset of b
+    static bool isSubset(const FlatSet& a, const FlatSet& b) {
+        if (a.size() > b.size()) return false;
+        if (skewed(a.size(), b.size())) {
+            size_t j = 0;
+            for (const T& x : a.items) {
+                j = gallop(b.data(), j, b.size(), x);
+                if (j == b.size() || x < b[j]) return false;
+                j++;
+            }
+            return true;
+        }
+        return includes(b.items.begin(), b.items.end(), a.items.begin(), a.items.end());
+    }
+};
+
+#endif
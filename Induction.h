@@ -5,166 +5,392 @@
 #include <vector>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <algorithm>
 #include <iostream>
 #include <limits>
+#include <cstdint>
 #include "BaseClasses.h"
+#include "PrerequisiteGraph.h"
+#include "Eligibility.h"
+#include "Parallel.h"
+#include "Trace.h"
 using namespace std;
 
+// Outcome of a strong-induction eligibility query
+struct StrongInductionResult {
+    bool satisfied = false;     // all prerequisites of the target are completed
+    bool cyclic = false;        // a prerequisite cycle was reached
+    vector<string> missing;     // uncompleted prerequisites, prerequisites first
+    vector<string> frontier;    // missing courses that can be taken right now
+    size_t visited = 0;         // courses expanded (each at most once)
+};
+
+// One prerequisite that does not appear earlier in a chain
+struct ChainViolation {
+    uint32_t chain;             // index of the chain in the batch
+    uint32_t position;          // 0-based position of the offending course
+    uint32_t course;            // interned ids, decode with PrerequisiteGraph::name
+    uint32_t prereq;
+};
+
+// Result of verifying many chains at once
+struct ChainBatchReport {
+    vector<char> valid;                 // one flag per chain
+    vector<ChainViolation> violations;  // ordered by chain, then position
+
+    size_t invalidCount() const {
+        return count(valid.begin(), valid.end(), 0);
+    }
+};
+
 //Induction & Strong Induction Module
 class InductionVerifier {
 private:
     map<string, set<string>> prerequisites;
+    TraceSink* trace = &consoleTrace();
 
 public:
+    // Narration for verifyPrerequisiteChain / verifyWithStrongInduction
+    void setTraceSink(TraceSink& sink) { trace = &sink; }
+
     void addPrerequisite(const string& course, const string& prereq) {
         prerequisites[course].insert(prereq);
     }
 
-    // VERIFY USING MATHEMATICAL INDUCTION
-    bool verifyPrerequisiteChain(const vector<string>& chain) {
-        cout << endl;
-        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
-        cout << "     MATHEMATICAL INDUCTION PROOF"<<endl;
-        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
-        cout << endl;
-        cout << endl;
-        cout << "[INFO] Prerequisite Chain to Verify:"<<endl;
-        cout << "Chain: ";
-        for (const auto& course : chain) cout << course << " ? ";
-        cout << "END"<<endl<<endl;
+    PrerequisiteGraph buildGraph() const {
+        return PrerequisiteGraph::build(prerequisites);
+    }
 
-        // Base case
-        cout << "    BASE CASE (n=1)"<<endl;
-        cout << "Course: " << chain[0] << endl;
+    // VERIFY USING MATHEMATICAL INDUCTION
+    bool verifyPrerequisiteChain(const vector<string>& chain) const {
+        bool proof = trace->wants(TraceLevel::Proof);
+        bool summary = trace->wants(TraceLevel::Summary);
+        ostream& out = trace->stream();
+
+        if (proof) {
+            out << "\n";
+            out << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << "\n";
+            out << "     MATHEMATICAL INDUCTION PROOF" << "\n";
+            out << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << "\n";
+            out << "\n\n";
+            out << "[INFO] Prerequisite Chain to Verify:" << "\n";
+            out << "Chain: ";
+            for (const auto& course : chain) out << course << " ? ";
+            out << "END" << "\n\n";
+
+            // Base case
+            out << "    BASE CASE (n=1)" << "\n";
+            out << "Course: " << chain[0] << "\n";
+        }
 
-        if (prerequisites[chain[0]].empty()) {
-            cout << "Prerequisites: None"<<endl;
-            cout << "[SUCCESS]  Base case holds - First course has no prerequisites"<<endl;
+        const set<string>& first = prerequisitesOf(chain[0]);
+        if (first.empty()) {
+            if (proof) {
+                out << "Prerequisites: None" << "\n";
+                out << "[SUCCESS]  Base case holds - First course has no prerequisites" << "\n";
+            }
         }
         else {
-            cout << "Prerequisites: ";
-            for (const auto& p : prerequisites[chain[0]]) cout << p << " ";
-            cout << endl;
-            cout << "[ERROR]  Base case fails - First course has prerequisites!"<<endl;
+            if (proof) {
+                out << "Prerequisites: ";
+                for (const auto& p : first) out << p << " ";
+                out << "\n";
+            }
+            if (summary) out << "[ERROR]  Base case fails - First course has prerequisites!" << "\n";
+            trace->flush();
             return false;
         }
 
         // Inductive step
-        cout << endl;
-        cout << "    INDUCTIVE HYPOTHESIS"<<endl;
-        cout << "Assume: Student can take all courses up to position k"<<endl;
-        cout << endl;
-        cout << "    INDUCTIVE STEP "<<endl;
-        cout << "Prove: Student can take course at position k+1"<<endl<<endl;
+        if (proof) {
+            out << "\n";
+            out << "    INDUCTIVE HYPOTHESIS" << "\n";
+            out << "Assume: Student can take all courses up to position k" << "\n";
+            out << "\n";
+            out << "    INDUCTIVE STEP " << "\n";
+            out << "Prove: Student can take course at position k+1" << "\n\n";
+        }
+
+        // First position of every course seen so far
+        unordered_map<string, size_t> position;
+        position.emplace(chain[0], 0);
 
         bool valid = true;
         for (size_t i = 1; i < chain.size(); i++) {
-            cout << "    Step " << i << ": Verify " << chain[i] << "     "<<endl;
+            const set<string>& reqs = prerequisitesOf(chain[i]);
+            if (proof) out << "    Step " << i << ": Verify " << chain[i] << "     " << "\n";
 
-            if (prerequisites[chain[i]].empty()) {
-                cout << "Prerequisites: None"<<endl;
-                cout << "[SUCCESS]  Can be taken at any time"<<endl<<endl;
+            if (reqs.empty()) {
+                if (proof) {
+                    out << "Prerequisites: None" << "\n";
+                    out << "[SUCCESS]  Can be taken at any time" << "\n\n";
+                }
             }
             else {
-                cout << "Prerequisites required: { ";
-                for (const auto& prereq : prerequisites[chain[i]]) {
-                    cout << prereq << " ";
+                if (proof) {
+                    out << "Prerequisites required: { ";
+                    for (const auto& prereq : reqs) out << prereq << " ";
+                    out << "}" << "\n";
                 }
-                cout << "}"<<endl;
 
                 // Check if all prerequisites appear before this in chain
                 bool allSatisfied = true;
-                for (const auto& prereq : prerequisites[chain[i]]) {
-                    bool found = false;
-                    for (size_t j = 0; j < i; j++) {
-                        if (chain[j] == prereq) {
-                            found = true;
-                            cout << "  ? " << prereq << " satisfied at position " << (j + 1) << endl;
-                            break;
-                        }
+                for (const auto& prereq : reqs) {
+                    auto at = position.find(prereq);
+                    if (at != position.end()) {
+                        if (proof) out << "  ? " << prereq << " satisfied at position " << (at->second + 1) << "\n";
                     }
-                    if (!found) {
-                        cout << "  ? " << prereq << " NOT satisfied!"<<endl;
+                    else {
+                        if (proof) out << "  ? " << prereq << " NOT satisfied!" << "\n";
                         allSatisfied = false;
                         valid = false;
                     }
                 }
 
-                if (allSatisfied) {
-                    cout << "[SUCCESS]  All prerequisites satisfied by inductive hypothesis"<<endl<<endl;
-                }
-                else {
-                    cout << "[ERROR]  Prerequisite violation detected!"<<endl<<endl;
+                if (proof) {
+                    if (allSatisfied) {
+                        out << "[SUCCESS]  All prerequisites satisfied by inductive hypothesis" << "\n\n";
+                    }
+                    else {
+                        out << "[ERROR]  Prerequisite violation detected!" << "\n\n";
+                    }
                 }
             }
+            position.emplace(chain[i], i);
         }
 
-        cout << "    CONCLUSION "<<endl;
-        if (valid) {
-            cout << "[SUCCESS]  By mathematical induction, the chain is VALID"<<endl;
-            cout << "Every course's prerequisites are satisfied before enrollment."<<endl;
-        }
-        else {
-            cout << "[ERROR]  PROOF FAILS - Chain violates prerequisite constraints"<<endl;
+        if (proof) out << "    CONCLUSION " << "\n";
+        if (summary) {
+            if (valid) {
+                out << "[SUCCESS]  By mathematical induction, the chain is VALID" << "\n";
+                if (proof) out << "Every course's prerequisites are satisfied before enrollment." << "\n";
+            }
+            else {
+                out << "[ERROR]  PROOF FAILS - Chain violates prerequisite constraints" << "\n";
+            }
         }
+        trace->flush();
 
         return valid;
     }
 
     // VERIFY USING STRONG INDUCTION
-    bool verifyWithStrongInduction(const string& course, const set<string>& completed) {
-        cout << endl;
-        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
-        cout << "     STRONG INDUCTION VERIFICATION"<<endl;
-        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
-        cout << endl;
-        cout<<endl;
-        cout << "[INFO] Target Course: " << course << endl;
-        cout << "[INFO] Completed Courses: { ";
-        for (const auto& c : completed) cout << c << " ";
-        cout << "}"<<endl<<endl;
+    bool verifyWithStrongInduction(const string& course, const set<string>& completed) const {
+        bool proof = trace->wants(TraceLevel::Proof);
+        bool summary = trace->wants(TraceLevel::Summary);
+        ostream& out = trace->stream();
+
+        if (proof) {
+            out << "\n";
+            out << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << "\n";
+            out << "     STRONG INDUCTION VERIFICATION" << "\n";
+            out << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << "\n";
+            out << "\n\n";
+            out << "[INFO] Target Course: " << course << "\n";
+            out << "[INFO] Completed Courses: { ";
+            for (const auto& c : completed) out << c << " ";
+            out << "}" << "\n\n";
+
+            out << "    STRONG INDUCTION PRINCIPLE " << "\n";
+            out << "To prove P(n), we can assume P(1), P(2), ..., P(n-1) are ALL true" << "\n";
+            out << "(Unlike regular induction which only assumes P(k))" << "\n\n";
+        }
 
-        cout << "    STRONG INDUCTION PRINCIPLE "<<endl;
-        cout << "To prove P(n), we can assume P(1), P(2), ..., P(n-1) are ALL true"<<endl;
-        cout << "(Unlike regular induction which only assumes P(k))"<<endl<<endl;
+        StrongInductionResult result = evaluate(course, completed, proof ? &out : nullptr);
+
+        if (summary) {
+            out << "\n";
+            if (result.satisfied) {
+                out << "[SUCCESS]  Every prerequisite of " << course << " is completed" << "\n";
+            }
+            else {
+                out << "[ERROR]  " << course << " is not yet reachable" << "\n";
+                out << "Missing prerequisites: { ";
+                for (const auto& m : result.missing) out << m << " ";
+                out << "}" << "\n";
+                out << "Take next: { ";
+                for (const auto& f : result.frontier) out << f << " ";
+                out << "}" << "\n";
+                if (result.cyclic) out << "[ERROR]  Circular prerequisite detected" << "\n";
+            }
+            if (proof) out << "[INFO] Courses examined: " << result.visited << "\n";
+        }
+        trace->flush();
 
-        return verifyStrongHelper(course, completed, 0);
+        return result.satisfied;
     }
 
-private:
-    bool verifyStrongHelper(const string& course, const set<string>& completed, int depth) {
-        string indent(depth * 2, ' ');
+    // BATCH CHAIN VERIFICATION
+    // Verifies many transcripts / planned chains without printing. Each chain is
+    // checked in one pass using a position index keyed by interned course id,
+    // and chains are split across worker threads.
+    ChainBatchReport verifyChainsBatch(const vector<vector<string>>& chains,
+        unsigned threads = 0) const {
+        PrerequisiteGraph graph = buildGraph();
+        vector<vector<uint32_t>> interned(chains.size());
+
+        parallelFor(chains.size(), workerCount(chains.size(), 256, threads),
+            [&](size_t begin, size_t end, unsigned) {
+                for (size_t c = begin; c < end; c++) {
+                    interned[c].reserve(chains[c].size());
+                    for (const auto& course : chains[c]) interned[c].push_back(graph.id(course));
+                }
+            });
+
+        return verifyChainsBatch(interned, graph, threads);
+    }
+
+    // Chains given as ids from graph; courses unknown to the graph are IdInterner::npos
+    static ChainBatchReport verifyChainsBatch(const vector<vector<uint32_t>>& chains,
+        const PrerequisiteGraph& graph, unsigned threads = 0) {
+        ChainBatchReport report;
+        report.valid.assign(chains.size(), 1);
+
+        unsigned workers = workerCount(chains.size(), 256, threads);
+        vector<vector<ChainViolation>> found(workers);
 
-        cout << indent << "Checking: " << course << endl;
+        parallelFor(chains.size(), workers, [&](size_t begin, size_t end, unsigned w) {
+            // seenIn[c] == chain + 1 when course c occurred earlier in that chain
+            vector<uint32_t> seenIn(graph.size(), 0);
 
-        // Base case
-        if (prerequisites[course].empty()) {
-            cout << indent << "  [SUCCESS]  No prerequisites"<<endl;
-            return true;
+            for (size_t c = begin; c < end; c++) {
+                uint32_t tag = (uint32_t)c + 1;
+                const auto& chain = chains[c];
+
+                for (size_t i = 0; i < chain.size(); i++) {
+                    uint32_t course = chain[i];
+                    if (course == IdInterner::npos) continue;
+
+                    for (uint32_t p : graph.prerequisitesOf(course)) {
+                        if (seenIn[p] != tag) {
+                            found[w].push_back({ (uint32_t)c, (uint32_t)i, course, p });
+                            report.valid[c] = 0;
+                        }
+                    }
+                    seenIn[course] = tag;
+                }
+            }
+        });
+
+        size_t total = 0;
+        for (const auto& f : found) total += f.size();
+        report.violations.reserve(total);
+        for (const auto& f : found) {
+            report.violations.insert(report.violations.end(), f.begin(), f.end());
         }
+        return report;
+    }
 
-        // Check each prerequisite
-        cout << indent << "  Prerequisites: { ";
-        for (const auto& p : prerequisites[course]) cout << p << " ";
-        cout << "}"<<endl;
+    // MEMOIZED STRONG INDUCTION
+    // Walks the uncompleted part of the prerequisite DAG once (iterative DFS),
+    // so shared prerequisites are expanded a single time per query.
+    StrongInductionResult evaluateStrongInduction(const string& course,
+        const set<string>& completed) const {
+        return evaluate(course, completed, nullptr);
+    }
+
+private:
+    // Narrates each step to `narration` when it is non-null
+    StrongInductionResult evaluate(const string& course,
+        const set<string>& completed, ostream* narration) const {
+        enum : char { Unseen, Active, Done };
+        struct Frame {
+            const string* course;
+            set<string>::const_iterator next, end;
+            int depth;
+        };
+
+        StrongInductionResult result;
+        unordered_map<string, char> state;
+        vector<Frame> stack;
+
+        auto push = [&](const string& c, int depth) {
+            const set<string>& reqs = prerequisitesOf(c);
+            state[c] = Active;
+            result.visited++;
+            if (narration) {
+                ostream& out = *narration;
+                string indent(depth * 2, ' ');
+                out << indent << "Checking: " << c << "\n";
+                if (reqs.empty()) {
+                    out << indent << "  [SUCCESS]  No prerequisites" << "\n";
+                }
+                else {
+                    out << indent << "  Prerequisites: { ";
+                    for (const auto& p : reqs) out << p << " ";
+                    out << "}" << "\n";
+                }
+            }
+            stack.push_back({ &c, reqs.begin(), reqs.end(), depth });
+        };
+
+        push(course, 0);
+        while (!stack.empty()) {
+            Frame& top = stack.back();
+
+            if (top.next == top.end) {
+                const string& c = *top.course;
+                bool ready = isReady(c, completed);
+                state[c] = Done;
+                if (stack.size() > 1) {
+                    result.missing.push_back(c);
+                    if (ready) result.frontier.push_back(c);
+                }
+                if (narration && !prerequisitesOf(c).empty()) {
+                    *narration << string(top.depth * 2, ' ')
+                        << (ready ? "  [SUCCESS]  All prerequisites completed"
+                                  : "  [ERROR]  Prerequisites still missing") << "\n";
+                }
+                stack.pop_back();
+                continue;
+            }
 
-        for (const auto& prereq : prerequisites[course]) {
-            cout << indent << " - " << prereq;
+            const string& prereq = *top.next++;
+            int depth = top.depth;
+            const char* note = nullptr;
 
             if (completed.find(prereq) != completed.end()) {
-                cout << "  (completed)"<<endl;
+                note = "  (completed)";
             }
             else {
-                cout << "  (not completed)"<<endl;
-                cout << indent << "    Using strong induction to verify " << prereq << ":"<<endl;
-
-                if (!verifyStrongHelper(prereq, completed, depth + 1)) {
-                    return false;
+                char& s = state[prereq];
+                if (s == Active) {
+                    result.cyclic = true;
+                    note = "  (cycle!)";
+                }
+                else if (s == Done) {
+                    note = "  (already verified)";
                 }
             }
+
+            if (note) {
+                if (narration) *narration << string(depth * 2, ' ') << " - " << prereq << note << "\n";
+                continue;
+            }
+
+            if (narration) {
+                string indent(depth * 2, ' ');
+                *narration << indent << " - " << prereq << "  (not completed)" << "\n";
+                *narration << indent << "    Using strong induction to verify " << prereq << ":" << "\n";
+            }
+            push(prereq, depth + 1);
         }
 
-        cout << indent << "  [SUCCESS]  All prerequisites verified"<<endl;
+        result.satisfied = isReady(course, completed);
+        return result;
+    }
+
+    const set<string>& prerequisitesOf(const string& course) const {
+        static const set<string> none;
+        auto it = prerequisites.find(course);
+        return it == prerequisites.end() ? none : it->second;
+    }
+
+    bool isReady(const string& course, const set<string>& completed) const {
+        for (const auto& p : prerequisitesOf(course)) {
+            if (completed.find(p) == completed.end()) return false;
+        }
         return true;
     }
 
@@ -261,21 +487,30 @@ public:
         for (const auto& c : completed) cout << c << " ";
         cout << "}"<<endl;
 
+        // Eligibility frontier from the student's record
+        EligibilityTracker tracker = eligibilityFor(courses);
+        tracker.syncStudent(student);
+        vector<string> next = tracker.nextCourses(student.getId());
+        sort(next.begin(), next.end());
+
         if (completed.empty()) {
             cout << endl;
             cout << "[INFO] Freshman student - no courses completed yet"<<endl;
             cout << "[INFO] Can take any course with no prerequisites"<<endl;
+        }
 
-            // Show available courses
-            cout << endl;
-            cout << "[INFO] Available courses:"<<endl;
+        // Show available courses
+        cout << endl;
+        cout << "[INFO] Available courses:"<<endl;
+        for (const auto& id : next) {
             for (const auto& c : courses) {
-                if (c.getPrerequisites().empty()) {
+                if (c.getId() == id) {
                     cout << "  ? " << c.getId() << " - " << c.getName() << endl;
+                    break;
                 }
             }
-            return;
         }
+        if (completed.empty()) return;
 
         // Now select a target course
         cout << endl;
@@ -466,6 +701,19 @@ public:
         cout << "     EXAMPLE 3: Strong Induction "<<endl;
         set<string> completed = { "CS101", "Math101", "CS201" };
         verifier.verifyWithStrongInduction("CS301", completed);
+
+        // Batch audit of several transcripts at once
+        cout << endl << endl;
+        cout << "     EXAMPLE 4: Batch Transcript Audit "<<endl;
+        vector<vector<string>> transcripts = { chain, badChain, { "Math101", "Math201" } };
+        ChainBatchReport report = verifier.verifyChainsBatch(transcripts);
+        PrerequisiteGraph graph = verifier.buildGraph();
+        cout << "[INFO] Chains checked: " << transcripts.size()
+            << ", invalid: " << report.invalidCount() << endl;
+        for (const auto& v : report.violations) {
+            cout << "  Chain " << (v.chain + 1) << ", position " << (v.position + 1) << ": "
+                << graph.name(v.course) << " needs " << graph.name(v.prereq) << " first" << endl;
+        }
         cout << endl;
         cout << "[SUCCESS] Module 3 Complete!"<<endl;
     }
@@ -0,0 +1,42 @@
+#ifndef INTERNER_H
+#define INTERNER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+using namespace std;
+
+// String Interning
+// Maps names (course IDs, fact atoms, ...) to dense ids 0, 1, 2, ...
+class IdInterner {
+private:
+    unordered_map<string, uint32_t> ids;
+    vector<string> names;
+
+public:
+    static constexpr uint32_t npos = UINT32_MAX;
+
+    uint32_t intern(const string& name) {
+        auto inserted = ids.try_emplace(name, (uint32_t)names.size());
+        if (inserted.second) names.push_back(name);
+        return inserted.first->second;
+    }
+
+    // Returns npos for names that were never interned
+    uint32_t find(const string& name) const {
+        auto it = ids.find(name);
+        return it == ids.end() ? npos : it->second;
+    }
+
+    bool contains(const string& name) const { return ids.find(name) != ids.end(); }
+    const string& name(uint32_t id) const { return names[id]; }
+    size_t size() const { return names.size(); }
+
+    void reserve(size_t n) {
+        ids.reserve(n);
+        names.reserve(n);
+    }
+};
+
+#endif
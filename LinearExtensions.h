@@ -0,0 +1,473 @@
+#ifndef LINEAR_EXTENSIONS_H
+#define LINEAR_EXTENSIONS_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <cstdint>
+#include "PrerequisiteGraph.h"
+using namespace std;
+
+// Exact non-negative integer (base 1e9 limbs, least significant first).
+// Ordering counts pass 2^64 quickly: 21 independent courses already do.
+class BigCount {
+private:
+    static constexpr uint32_t BASE = 1000000000;
+    vector<uint32_t> limbs;
+
+    void trim() {
+        while (!limbs.empty() && limbs.back() == 0) limbs.pop_back();
+    }
+
+public:
+    BigCount(uint64_t v = 0) {
+        while (v) {
+            limbs.push_back((uint32_t)(v % BASE));
+            v /= BASE;
+        }
+    }
+
+    bool isZero() const { return limbs.empty(); }
+
+    BigCount& operator+=(const BigCount& o) {
+        if (limbs.size() < o.limbs.size()) limbs.resize(o.limbs.size(), 0);
+        uint64_t carry = 0;
+        for (size_t i = 0; i < limbs.size(); i++) {
+            uint64_t s = carry + limbs[i] + (i < o.limbs.size() ? o.limbs[i] : 0);
+            limbs[i] = (uint32_t)(s % BASE);
+            carry = s / BASE;
+        }
+        if (carry) limbs.push_back((uint32_t)carry);
+        return *this;
+    }
+
+    // Requires *this >= o
+    BigCount& operator-=(const BigCount& o) {
+        int64_t borrow = 0;
+        for (size_t i = 0; i < limbs.size(); i++) {
+            int64_t d = (int64_t)limbs[i] - borrow - (i < o.limbs.size() ? o.limbs[i] : 0);
+            borrow = d < 0;
+            limbs[i] = (uint32_t)(d < 0 ? d + BASE : d);
+        }
+        trim();
+        return *this;
+    }
+
+    BigCount& operator*=(uint32_t m) {
+        if (m == 0) {
+            limbs.clear();
+            return *this;
+        }
+        uint64_t carry = 0;
+        for (auto& l : limbs) {
+            uint64_t p = (uint64_t)l * m + carry;
+            l = (uint32_t)(p % BASE);
+            carry = p / BASE;
+        }
+        while (carry) {
+            limbs.push_back((uint32_t)(carry % BASE));
+            carry /= BASE;
+        }
+        return *this;
+    }
+
+    BigCount operator*(const BigCount& o) const {
+        BigCount r;
+        if (isZero() || o.isZero()) return r;
+        vector<uint64_t> acc(limbs.size() + o.limbs.size() + 1, 0);
+        for (size_t i = 0; i < limbs.size(); i++) {
+            uint64_t carry = 0;
+            for (size_t j = 0; j < o.limbs.size(); j++) {
+                uint64_t cur = acc[i + j] + (uint64_t)limbs[i] * o.limbs[j] + carry;
+                acc[i + j] = cur % BASE;
+                carry = cur / BASE;
+            }
+            for (size_t k = i + o.limbs.size(); carry; k++) {
+                uint64_t cur = acc[k] + carry;
+                acc[k] = cur % BASE;
+                carry = cur / BASE;
+            }
+        }
+        r.limbs.assign(acc.begin(), acc.end());
+        r.trim();
+        return r;
+    }
+
+    // Divides in place, returns the remainder
+    uint32_t divide(uint32_t d) {
+        uint64_t rem = 0;
+        for (size_t i = limbs.size(); i-- > 0;) {
+            uint64_t cur = limbs[i] + rem * BASE;
+            limbs[i] = (uint32_t)(cur / d);
+            rem = cur % d;
+        }
+        trim();
+        return (uint32_t)rem;
+    }
+
+    bool operator<(const BigCount& o) const {
+        if (limbs.size() != o.limbs.size()) return limbs.size() < o.limbs.size();
+        for (size_t i = limbs.size(); i-- > 0;) {
+            if (limbs[i] != o.limbs[i]) return limbs[i] < o.limbs[i];
+        }
+        return false;
+    }
+    bool operator==(const BigCount& o) const { return limbs == o.limbs; }
+
+    string toString() const {
+        if (limbs.empty()) return "0";
+        string s = to_string(limbs.back());
+        for (size_t i = limbs.size() - 1; i-- > 0;) {
+            string part = to_string(limbs[i]);
+            s += string(9 - part.size(), '0') + part;
+        }
+        return s;
+    }
+
+    // C(n, k), exact at every step since i+1 consecutive integers are divisible by (i+1)!
+    static BigCount binomial(uint32_t n, uint32_t k) {
+        if (k > n) return BigCount(0);
+        k = min(k, n - k);
+        BigCount r(1);
+        for (uint32_t i = 0; i < k; i++) {
+            r *= (n - i);
+            r.divide(i + 1);
+        }
+        return r;
+    }
+
+    // Uniform value in [0, bound), bound > 0
+    template <typename Rng>
+    static BigCount uniformBelow(const BigCount& bound, Rng& rng) {
+        uniform_int_distribution<uint32_t> limb(0, BASE - 1);
+        uniform_int_distribution<uint32_t> top(0, bound.limbs.back());
+        while (true) {
+            BigCount r;
+            r.limbs.resize(bound.limbs.size());
+            for (size_t i = 0; i + 1 < r.limbs.size(); i++) r.limbs[i] = limb(rng);
+            r.limbs.back() = top(rng);
+            r.trim();
+            if (r < bound) return r;
+        }
+    }
+};
+
+// Linear Extensions
+// Counts and uniformly samples the valid orderings (topological orders) of a
+// prerequisite graph. The poset is split recursively into parallel parts
+// (independent components, combined with a multinomial) and series parts
+// (blocks that must come entirely before the next); the remaining connected
+// blocks are counted with a DP over their downsets (prerequisite-closed subsets).
+class LinearExtensions {
+private:
+    static constexpr size_t DENSE_LIMIT = 20;     // 2^20 uint64 table
+    static constexpr size_t SPARSE_LIMIT = 64;    // downsets keyed by uint64 mask
+
+    enum class Kind { Leaf, Series, Parallel };
+
+    struct Node {
+        Kind kind;
+        vector<uint32_t> children;        // node indices
+        vector<uint32_t> elements;        // leaf: course ids, local bit i = elements[i]
+        vector<uint64_t> predMask;        // leaf: local prerequisite masks
+        vector<uint64_t> dense;           // leaf <= DENSE_LIMIT: completions per downset
+        unordered_map<uint64_t, BigCount> sparse;
+        size_t size = 0;
+        BigCount count;
+    };
+
+    PrerequisiteGraph graph;
+    vector<Node> nodes;
+    uint32_t root = 0;
+
+    // Scratch indexed by course id; only entries of the current piece are
+    // touched, and flags are cleared again before returning
+    vector<uint32_t> stamp;
+    uint32_t stampValue = 0;
+    vector<char> flag;
+    vector<uint32_t> counter;
+
+    uint32_t mark(const vector<uint32_t>& piece) {
+        stampValue++;
+        for (uint32_t v : piece) stamp[v] = stampValue;
+        return stampValue;
+    }
+
+    vector<vector<uint32_t>> components(const vector<uint32_t>& piece) {
+        uint32_t in = mark(piece);
+        vector<vector<uint32_t>> result;
+
+        for (uint32_t start : piece) {
+            if (flag[start]) continue;
+            vector<uint32_t> comp = { start };
+            flag[start] = 1;
+            for (size_t i = 0; i < comp.size(); i++) {
+                uint32_t v = comp[i];
+                auto visit = [&](uint32_t u) {
+                    if (stamp[u] == in && !flag[u]) {
+                        flag[u] = 1;
+                        comp.push_back(u);
+                    }
+                };
+                for (uint32_t u : graph.prerequisitesOf(v)) visit(u);
+                for (uint32_t u : graph.dependentsOf(v)) visit(u);
+            }
+            result.push_back(comp);
+        }
+        for (uint32_t v : piece) flag[v] = 0;
+        return result;
+    }
+
+    // Splits a connected piece into blocks B1 < B2 < ... where every course of
+    // Bi precedes every course of Bi+1. Walks a Kahn order: at prefix P the
+    // ready set R is the set of minimal remaining courses, and the cut is
+    // valid iff every maximal course of P is a direct prerequisite of every
+    // course in R.
+    vector<vector<uint32_t>> seriesBlocks(const vector<uint32_t>& piece) {
+        uint32_t in = mark(piece);
+        vector<uint32_t>& indeg = counter;
+        vector<char>& maximal = flag;
+        for (uint32_t v : piece) {
+            uint32_t d = 0;
+            for (uint32_t p : graph.prerequisitesOf(v)) d += stamp[p] == in;
+            indeg[v] = d;
+        }
+
+        deque<uint32_t> ready;
+        for (uint32_t v : piece) if (indeg[v] == 0) ready.push_back(v);
+
+        size_t maxCount = 0;
+        vector<vector<uint32_t>> blocks(1);
+
+        while (!ready.empty()) {
+            uint32_t v = ready.front();
+            ready.pop_front();
+            blocks.back().push_back(v);
+
+            maximal[v] = 1;
+            maxCount++;
+            for (uint32_t p : graph.prerequisitesOf(v)) {
+                if (stamp[p] == in && maximal[p]) {
+                    maximal[p] = 0;
+                    maxCount--;
+                }
+            }
+            for (uint32_t d : graph.dependentsOf(v)) {
+                if (stamp[d] == in && --indeg[d] == 0) ready.push_back(d);
+            }
+
+            if (ready.empty()) continue;
+            bool cut = true;
+            for (uint32_t r : ready) {
+                size_t linked = 0;
+                for (uint32_t p : graph.prerequisitesOf(r)) linked += stamp[p] == in && maximal[p];
+                if (linked != maxCount) {
+                    cut = false;
+                    break;
+                }
+            }
+            if (cut) blocks.emplace_back();
+        }
+        for (uint32_t v : piece) maximal[v] = 0;
+
+        size_t placed = 0;
+        for (const auto& b : blocks) placed += b.size();
+        if (placed != piece.size()) {
+            throw runtime_error("Prerequisite graph has a cycle; no valid ordering exists");
+        }
+        return blocks;
+    }
+
+    uint32_t build(const vector<uint32_t>& piece) {
+        auto comps = components(piece);
+        if (comps.size() > 1) {
+            Node node;
+            node.kind = Kind::Parallel;
+            node.size = piece.size();
+            node.count = BigCount(1);
+            size_t placed = 0;
+            for (const auto& c : comps) {
+                uint32_t child = build(c);
+                node.children.push_back(child);
+                placed += c.size();
+                node.count = node.count * nodes[child].count;
+                node.count = node.count * BigCount::binomial((uint32_t)placed, (uint32_t)c.size());
+            }
+            nodes.push_back(move(node));
+            return (uint32_t)nodes.size() - 1;
+        }
+
+        auto blocks = seriesBlocks(piece);
+        if (blocks.size() > 1) {
+            Node node;
+            node.kind = Kind::Series;
+            node.size = piece.size();
+            node.count = BigCount(1);
+            for (const auto& b : blocks) {
+                uint32_t child = build(b);
+                node.children.push_back(child);
+                node.count = node.count * nodes[child].count;
+            }
+            nodes.push_back(move(node));
+            return (uint32_t)nodes.size() - 1;
+        }
+
+        return buildLeaf(piece);
+    }
+
+    uint32_t buildLeaf(const vector<uint32_t>& piece) {
+        if (piece.size() > SPARSE_LIMIT) {
+            throw runtime_error("Curriculum block of " + to_string(piece.size()) +
+                " tightly coupled courses is too large to count exactly");
+        }
+
+        Node node;
+        node.kind = Kind::Leaf;
+        node.size = piece.size();
+        node.elements = piece;
+
+        unordered_map<uint32_t, uint32_t> local;
+        for (uint32_t i = 0; i < piece.size(); i++) local[piece[i]] = i;
+        node.predMask.assign(piece.size(), 0);
+        for (uint32_t i = 0; i < piece.size(); i++) {
+            for (uint32_t p : graph.prerequisitesOf(piece[i])) {
+                auto it = local.find(p);
+                if (it != local.end()) node.predMask[i] |= 1ULL << it->second;
+            }
+        }
+
+        uint64_t full = piece.size() == 64 ? ~0ULL : (1ULL << piece.size()) - 1;
+        if (piece.size() <= DENSE_LIMIT) {
+            // Completions from each downset, filled from the full set downwards
+            node.dense.assign((size_t)full + 1, 0);
+            node.dense[full] = 1;
+            for (uint64_t mask = full; mask-- > 0;) {
+                uint64_t ways = 0;
+                for (size_t i = 0; i < piece.size(); i++) {
+                    uint64_t bit = 1ULL << i;
+                    if (!(mask & bit) && (node.predMask[i] & ~mask) == 0) ways += node.dense[mask | bit];
+                }
+                node.dense[mask] = ways;
+            }
+            node.count = BigCount(node.dense[0]);
+        }
+        else {
+            node.count = completions(node, 0, full);
+        }
+
+        nodes.push_back(move(node));
+        return (uint32_t)nodes.size() - 1;
+    }
+
+    // Memoized over reachable downsets only
+    BigCount completions(Node& node, uint64_t mask, uint64_t full) {
+        if (mask == full) return BigCount(1);
+        auto it = node.sparse.find(mask);
+        if (it != node.sparse.end()) return it->second;
+
+        BigCount ways;
+        for (size_t i = 0; i < node.size; i++) {
+            uint64_t bit = 1ULL << i;
+            if (!(mask & bit) && (node.predMask[i] & ~mask) == 0) ways += completions(node, mask | bit, full);
+        }
+        node.sparse.emplace(mask, ways);
+        return ways;
+    }
+
+    BigCount completionsOf(const Node& node, uint64_t mask) const {
+        if (!node.dense.empty()) return BigCount(node.dense[mask]);
+        uint64_t full = node.size == 64 ? ~0ULL : (1ULL << node.size) - 1;
+        if (mask == full) return BigCount(1);
+        return node.sparse.at(mask);
+    }
+
+    template <typename Rng>
+    void sampleNode(uint32_t index, Rng& rng, vector<uint32_t>& out) const {
+        const Node& node = nodes[index];
+
+        if (node.kind == Kind::Series) {
+            for (uint32_t c : node.children) sampleNode(c, rng, out);
+            return;
+        }
+
+        if (node.kind == Kind::Parallel) {
+            // Uniform interleaving of independent parts = shuffled part labels
+            vector<vector<uint32_t>> parts(node.children.size());
+            vector<uint32_t> labels;
+            labels.reserve(node.size);
+            for (uint32_t i = 0; i < node.children.size(); i++) {
+                sampleNode(node.children[i], rng, parts[i]);
+                labels.insert(labels.end(), parts[i].size(), i);
+            }
+            shuffle(labels.begin(), labels.end(), rng);
+            vector<size_t> next(parts.size(), 0);
+            for (uint32_t l : labels) out.push_back(parts[l][next[l]++]);
+            return;
+        }
+
+        // Leaf: pick each next course with probability proportional to the
+        // number of completions it leaves
+        uint64_t mask = 0;
+        for (size_t step = 0; step < node.size; step++) {
+            BigCount pick = BigCount::uniformBelow(completionsOf(node, mask), rng);
+            for (size_t i = 0; i < node.size; i++) {
+                uint64_t bit = 1ULL << i;
+                if ((mask & bit) || (node.predMask[i] & ~mask) != 0) continue;
+                BigCount ways = completionsOf(node, mask | bit);
+                if (pick < ways) {
+                    mask |= bit;
+                    out.push_back(node.elements[i]);
+                    break;
+                }
+                pick -= ways;
+            }
+        }
+    }
+
+public:
+    // Throws runtime_error if the graph is cyclic or has a tightly coupled
+    // block of more than 64 courses
+    explicit LinearExtensions(const PrerequisiteGraph& g) : graph(g) {
+        stamp.assign(graph.size(), 0);
+        flag.assign(graph.size(), 0);
+        counter.assign(graph.size(), 0);
+        vector<uint32_t> all(graph.size());
+        for (uint32_t i = 0; i < all.size(); i++) all[i] = i;
+
+        if (all.empty()) {
+            Node empty;
+            empty.kind = Kind::Series;
+            empty.count = BigCount(1);
+            nodes.push_back(empty);
+            root = 0;
+        }
+        else {
+            root = build(all);
+        }
+    }
+
+    // Number of valid orderings of all courses
+    const BigCount& count() const { return nodes[root].count; }
+
+    // One valid ordering, drawn uniformly at random
+    template <typename Rng>
+    vector<uint32_t> sample(Rng& rng) const {
+        vector<uint32_t> order;
+        order.reserve(graph.size());
+        sampleNode(root, rng, order);
+        return order;
+    }
+
+    template <typename Rng>
+    vector<string> sampleNames(Rng& rng) const {
+        vector<string> names;
+        for (uint32_t c : sample(rng)) names.push_back(graph.name(c));
+        return names;
+    }
+};
+
+#endif
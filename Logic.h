@@ -8,53 +8,775 @@
 #include <sstream>
 #include <algorithm>
 #include <limits>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdexcept>
+#include <queue>
+#include <iterator>
 #include "BaseClasses.h"
+#include "Interner.h"
+#include "Trace.h"
+#include "Datalog.h"
+#include "SatSolver.h"
 using namespace std;
 
 //  Logic & Inference Engine
+// Fact names are interned to dense atom ids. Each atom has an alpha memory
+// listing the rules whose condition mentions it, and infer() drains an agenda
+// of atoms that became true since the last run: a new fact only wakes the
+// rules that mention it, and inference runs until nothing new is derived.
+//
+// Conditions may combine atoms with AND, OR, NOT and parentheses. They are
+// hash-consed into a DAG shared by all rules, and each distinct condition is
+// compiled once into a flat program that infer() runs in a tight loop.
+//
+// When no atom depends on its own negation, infer() follows the strongly
+// connected components of the atom dependency graph in order instead of
+// looping over the whole rule base; analyzeRules() reports that plan.
 class LogicEngine {
+    friend class PopulationEvaluator;
+    friend class RuleFileLoader;
+
+public:
+    struct ConsistencyReport {
+        bool consistent = true;
+        vector<string> core;            // rules and facts that cannot all hold together
+        size_t variables = 0;
+        size_t clauses = 0;
+    };
+
+    // One step of an explanation: the fact, the rule that gives it (empty
+    // for a given fact) and the premises that rule needed
+    struct Justification {
+        string fact;
+        string rule;
+        vector<string> premises;        // atoms, or "NOT ..." for negated parts
+    };
+
+    struct RuleAnalysis {
+        bool stratified = true;         // no atom depends on its own negation
+        size_t strata = 0;
+        vector<vector<string>> cycles;  // atoms that derive each other
+        vector<string> negativeCycles;  // rules that break stratification
+        vector<string> deadRules;       // conditions that can never hold
+        vector<string> subsumedRules;   // implied by another rule with the same conclusion
+        vector<string> evaluationOrder; // rules in the order infer() runs them
+    };
+
 private:
-    map<string, bool> facts;
+    enum Truth : uint8_t { Unknown, True, False };
+    enum Op : uint8_t { OpAtom, OpNot, OpAnd, OpOr };
+
+    // Condition DAG node; children always have smaller ids than parents
+    struct Node {
+        Op op;
+        uint32_t a, b;          // OpAtom: a = atom id; otherwise child nodes
+    };
+
+    // Instruction i of a program writes register i; operands are registers,
+    // or the atom id for OpAtom
+    struct Instr {
+        Op op;
+        uint32_t a, b;
+    };
 
     struct Rule {
-        string condition;
-        string conclusion;
+        uint32_t condition;     // root node
+        uint32_t conclusion;    // atom id
+        uint32_t codeStart;
+        uint32_t codeLength;
         string description;
         string originalRule;
 
-        Rule(string c, string con, string d = "", string orig = "")
-            : condition(c), conclusion(con), description(d), originalRule(orig) {
+        Rule(uint32_t c, uint32_t con, string d = "", string orig = "")
+            : condition(c), conclusion(con), codeStart(0), codeLength(0),
+            description(d), originalRule(orig) {
         }
     };
 
+    static constexpr uint32_t none = IdInterner::npos;
+
+    IdInterner atoms;
+    vector<uint8_t> truth;              // by atom id
+    vector<uint8_t> base;               // set by addFact rather than derived
+    vector<uint32_t> support;           // rule that derived the atom, or none
+    vector<uint32_t> madeTrue;          // when the atom last became true, on the tick clock
+    uint32_t tick = 0;
     vector<Rule> rules;
 
+    vector<Node> nodes;
+    vector<pair<uint64_t, uint32_t>> nodeSlots;   // hash-consing table: (key, node id + 1), 0 if empty
+    vector<uint32_t> atomNode;          // atom id -> its OpAtom node, or none
+    vector<Instr> code;
+    vector<pair<uint32_t, uint32_t>> programs;     // root node -> (start, length), length 0 if none yet
+    vector<uint8_t> regs;
+    vector<uint32_t> nodeStamp;         // marks nodes already reached by program()
+    uint32_t nodeMark = 0;
+    vector<uint32_t> reach, pendingNodes;       // program() scratch
+
+    vector<uint32_t> freshRules;        // never evaluated yet
+    vector<uint32_t> ruleStamp;
+    uint32_t stamp = 0;
+
+    // Alpha memories as linked lists of (rule, next) links, one list per atom
+    vector<uint32_t> alphaHead, alphaTail;
+    vector<uint32_t> linkRule, linkNext;
+
+    vector<uint32_t> agenda;            // atoms made true since the last infer()
+
+    // Rules grouped by conclusion, for backward chaining
+    vector<uint32_t> firstRuleFor;      // atom -> first rule concluding it, or none
+    vector<uint32_t> nextRuleFor;       // rule -> next rule with the same conclusion
+
+    // Tabled query answers; valid while tableEpoch[a] == epoch
+    vector<uint32_t> tableEpoch;
+    vector<uint8_t> tableValue;
+    vector<uint32_t> atomStamp;
+    uint32_t epoch = 1;
+
+    // Evaluation plan over the atom dependency graph (see buildPlan)
+    vector<uint32_t> component;         // atom -> strongly connected component, sources first
+    vector<uint8_t> recursive;          // component -> lies on a cycle
+    bool stratified = false;
+    bool planValid = false;
+
+    TraceSink* trace = &consoleTrace();
+
+    uint32_t atom(const string& name) {
+        uint32_t id = atoms.intern(name);
+        if (id == truth.size()) {
+            truth.push_back(Unknown);
+            base.push_back(0);
+            support.push_back(none);
+            madeTrue.push_back(0);
+            alphaHead.push_back(none);
+            alphaTail.push_back(none);
+            atomNode.push_back(none);
+            firstRuleFor.push_back(none);
+            tableEpoch.push_back(0);
+            tableValue.push_back(0);
+            atomStamp.push_back(0);
+        }
+        return id;
+    }
+
+    // Room for n atoms in all per-atom tables (bulk loads)
+    void reserveAtoms(size_t n) {
+        atoms.reserve(n);
+        for (auto* v : { &support, &madeTrue, &alphaHead, &alphaTail, &atomNode, &firstRuleFor, &tableEpoch, &atomStamp }) v->reserve(n);
+        truth.reserve(n);
+        base.reserve(n);
+        tableValue.reserve(n);
+    }
+
+    // CONDITION COMPILER
+    uint32_t node(Op op, uint32_t a, uint32_t b = 0) {
+        if (op == OpAnd || op == OpOr) {
+            if (a == b) return a;
+            if (a > b) swap(a, b);
+        }
+        else if (op == OpNot && nodes[a].op == OpNot) {
+            return nodes[a].a;
+        }
+
+        uint64_t key = (uint64_t)op << 62 | (uint64_t)a << 31 | b;
+        if (nodeSlots.size() < 2 * (nodes.size() + 1)) growNodeSlots();
+        size_t s = nodeSlot(key);
+        if (nodeSlots[s].second != 0) return nodeSlots[s].second - 1;
+
+        uint32_t id = (uint32_t)nodes.size();
+        nodes.push_back({ op, a, b });
+        nodeSlots[s] = { key, id + 1 };
+        return id;
+    }
+
+    // Linear probing; the table is kept at most half full
+    size_t nodeSlot(uint64_t key) const {
+        size_t mask = nodeSlots.size() - 1;
+        size_t i = (size_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+        while (nodeSlots[i].second != 0 && nodeSlots[i].first != key) i = (i + 1) & mask;
+        return i;
+    }
+
+    void growNodeSlots() {
+        vector<pair<uint64_t, uint32_t>> old(max<size_t>(64, nodeSlots.size() * 2));
+        old.swap(nodeSlots);
+        for (const auto& slot : old) {
+            if (slot.second != 0) nodeSlots[nodeSlot(slot.first)] = slot;
+        }
+    }
+
+    uint32_t atomLeaf(uint32_t a) {
+        if (atomNode[a] == none) atomNode[a] = node(OpAtom, a);
+        return atomNode[a];
+    }
+
+    static bool isKeyword(string_view t) {
+        return t == "AND" || t == "OR" || t == "NOT" || t == "(" || t == ")";
+    }
+
+    static vector<string_view> tokenize(string_view text) {
+        vector<string_view> tokens;
+        size_t i = 0;
+        while (i < text.size()) {
+            char c = text[i];
+            if (c == ' ' || c == '\t') {
+                i++;
+            }
+            else if (c == '(' || c == ')') {
+                tokens.push_back(text.substr(i, 1));
+                i++;
+            }
+            else {
+                size_t j = i;
+                while (j < text.size() && text[j] != ' ' && text[j] != '\t' &&
+                    text[j] != '(' && text[j] != ')') j++;
+                tokens.push_back(text.substr(i, j - i));
+                i = j;
+            }
+        }
+        return tokens;
+    }
+
+    // Grammar: or := and {OR and};  and := unary {AND unary};
+    //          unary := NOT unary | ( or ) | word {word}
+    // Consecutive plain words form one atom, joined with '_'
+    uint32_t parseOr(const vector<string_view>& t, size_t& pos) {
+        uint32_t left = parseAnd(t, pos);
+        while (pos < t.size() && t[pos] == "OR") {
+            pos++;
+            left = node(OpOr, left, parseAnd(t, pos));
+        }
+        return left;
+    }
+
+    uint32_t parseAnd(const vector<string_view>& t, size_t& pos) {
+        uint32_t left = parseUnary(t, pos);
+        while (pos < t.size() && t[pos] == "AND") {
+            pos++;
+            left = node(OpAnd, left, parseUnary(t, pos));
+        }
+        return left;
+    }
+
+    uint32_t parseUnary(const vector<string_view>& t, size_t& pos) {
+        if (pos >= t.size()) throw runtime_error("condition ends unexpectedly");
+
+        if (t[pos] == "NOT") {
+            pos++;
+            return node(OpNot, parseUnary(t, pos));
+        }
+        if (t[pos] == "(") {
+            pos++;
+            uint32_t inner = parseOr(t, pos);
+            if (pos >= t.size() || t[pos] != ")") throw runtime_error("missing ')'");
+            pos++;
+            return inner;
+        }
+        if (isKeyword(t[pos])) throw runtime_error("unexpected '" + string(t[pos]) + "'");
+
+        string name(t[pos++]);
+        while (pos < t.size() && !isKeyword(t[pos])) {
+            name += '_';
+            name.append(t[pos++]);
+        }
+        return atomLeaf(atom(name));
+    }
+
+    uint32_t compileCondition(string_view text) {
+        vector<string_view> tokens = tokenize(text);
+        size_t pos = 0;
+        uint32_t root = parseOr(tokens, pos);
+        if (pos != tokens.size()) throw runtime_error("unexpected '" + string(tokens[pos]) + "'");
+        return root;
+    }
+
+    // Emits the sub-DAG under root once, in id order (children first)
+    pair<uint32_t, uint32_t> program(uint32_t root) {
+        if (programs.size() < nodes.size()) programs.resize(nodes.size(), { 0, 0 });
+        if (programs[root].second != 0) return programs[root];
+
+        reach.clear();
+        vector<uint32_t>& stack = pendingNodes;
+        stack.assign(1, root);
+        nodeStamp.resize(nodes.size(), 0);
+        uint32_t mark = ++nodeMark;
+        nodeStamp[root] = mark;
+        auto reached = [&](uint32_t n) {
+            if (nodeStamp[n] == mark) return true;
+            nodeStamp[n] = mark;
+            return false;
+        };
+        while (!stack.empty()) {
+            uint32_t id = stack.back();
+            stack.pop_back();
+            reach.push_back(id);
+
+            const Node& n = nodes[id];
+            if (n.op == OpAtom) continue;
+            if (!reached(n.a)) stack.push_back(n.a);
+            if (n.op != OpNot && !reached(n.b)) stack.push_back(n.b);
+        }
+        sort(reach.begin(), reach.end());
+
+        auto reg = [&](uint32_t n) {
+            return (uint32_t)(lower_bound(reach.begin(), reach.end(), n) - reach.begin());
+        };
+        uint32_t start = (uint32_t)code.size();
+        for (uint32_t n : reach) {
+            const Node& x = nodes[n];
+            if (x.op == OpAtom) code.push_back({ OpAtom, x.a, 0 });
+            else if (x.op == OpNot) code.push_back({ OpNot, reg(x.a), 0 });
+            else code.push_back({ x.op, reg(x.a), reg(x.b) });
+        }
+        uint32_t length = (uint32_t)reach.size();
+        if (regs.size() < length) regs.resize(length);
+        return programs[root] = { start, length };
+    }
+
+    // value(atom) supplies the truth of each atom the program reads
+    template <typename Value>
+    bool holds(const Rule& rule, Value value) {
+        const Instr* p = code.data() + rule.codeStart;
+        uint8_t* r = regs.data();
+        for (uint32_t i = 0; i < rule.codeLength; i++) {
+            switch (p[i].op) {
+            case OpAtom: r[i] = value(p[i].a); break;
+            case OpNot:  r[i] = !r[p[i].a]; break;
+            case OpAnd:  r[i] = r[p[i].a] & r[p[i].b]; break;
+            case OpOr:   r[i] = r[p[i].a] | r[p[i].b]; break;
+            }
+        }
+        return r[rule.codeLength - 1];
+    }
+
+    string operandText(uint32_t n) const {
+        Op op = nodes[n].op;
+        return op == OpAnd || op == OpOr ? "(" + conditionText(n) + ")" : conditionText(n);
+    }
+
+    string conditionText(uint32_t n) const {
+        const Node& x = nodes[n];
+        switch (x.op) {
+        case OpAtom: return atoms.name(x.a);
+        case OpNot:  return "NOT " + operandText(x.a);
+        default:     return operandText(x.a) + (x.op == OpAnd ? " AND " : " OR ") + operandText(x.b);
+        }
+    }
+
+    // Breadth-first agenda loop: iteration k runs the rules woken by atoms
+    // that changed in iteration k-1, plus the given candidate rules first.
+    // A rule runs only when an atom it mentions changes; NOT is checked
+    // against the facts known at that moment. Returns the facts derived.
+    size_t saturate(vector<uint32_t> wave, vector<uint32_t> candidates, int& iteration, ostream* narration) {
+        vector<uint32_t> next;
+        size_t derived = 0;
+        auto known = [&](uint32_t a) { return truth[a] == True; };
+
+        while (!wave.empty() || !candidates.empty()) {
+            iteration++;
+            stamp++;
+            for (uint32_t r : candidates) ruleStamp[r] = stamp;
+            for (uint32_t a : wave) {
+                for (uint32_t link = alphaHead[a]; link != none; link = linkNext[link]) {
+                    uint32_t r = linkRule[link];
+                    if (ruleStamp[r] == stamp) continue;
+                    ruleStamp[r] = stamp;
+                    candidates.push_back(r);
+                }
+            }
+
+            for (uint32_t r : candidates) {
+                const Rule& rule = rules[r];
+                if (truth[rule.conclusion] == True || !holds(rule, known)) continue;
+
+                derive(rule.conclusion, r);
+                next.push_back(rule.conclusion);
+                derived++;
+                if (narration) {
+                    *narration << "  Iteration " << iteration << ": '" << conditionText(rule.condition)
+                        << "' - '" << atoms.name(rule.conclusion) << "'\n";
+                }
+            }
+            candidates.clear();
+            wave.swap(next);
+            next.clear();
+        }
+        return derived;
+    }
+
+    // Each atom the rule reads, with bit 0 set if it occurs positively and
+    // bit 1 if it occurs under an odd number of NOTs
+    vector<pair<uint32_t, uint8_t>> literals(const Rule& rule) const {
+        const Instr* p = code.data() + rule.codeStart;
+        vector<uint8_t> polarity(rule.codeLength, 0);
+        polarity[rule.codeLength - 1] = 1;
+        vector<pair<uint32_t, uint8_t>> found;
+        for (uint32_t i = rule.codeLength; i-- > 0;) {
+            uint8_t pol = polarity[i];
+            if (p[i].op == OpAtom) found.push_back({ p[i].a, pol });
+            else if (p[i].op == OpNot) polarity[p[i].a] |= (uint8_t)((pol & 1) << 1 | pol >> 1);
+            else {
+                polarity[p[i].a] |= pol;
+                polarity[p[i].b] |= pol;
+            }
+        }
+        return found;
+    }
+
+    // Tarjan's algorithm, iteratively, over edges (atom read -> conclusion).
+    // Components are numbered so every edge goes forward, which makes the
+    // numbering an evaluation order; the rule base is stratified when no
+    // negative edge stays inside a component.
+    void buildPlan() {
+        size_t n = atoms.size();
+        vector<uint32_t> start(n + 1, 0), target;
+        vector<uint8_t> negative;
+        vector<pair<uint32_t, uint8_t>> reads;
+        vector<vector<pair<uint32_t, uint8_t>>> ruleReads(rules.size());
+        for (size_t r = 0; r < rules.size(); r++) {
+            ruleReads[r] = literals(rules[r]);
+            for (const auto& lit : ruleReads[r]) start[lit.first + 1]++;
+        }
+        for (size_t a = 0; a < n; a++) start[a + 1] += start[a];
+        target.resize(start[n]);
+        negative.resize(start[n]);
+        vector<uint32_t> fill(start.begin(), start.end() - 1);
+        for (size_t r = 0; r < rules.size(); r++) {
+            for (const auto& lit : ruleReads[r]) {
+                target[fill[lit.first]] = rules[r].conclusion;
+                negative[fill[lit.first]++] = (lit.second & 2) != 0;
+            }
+        }
+
+        vector<uint32_t> index(n, none), low(n, 0), stack;
+        vector<uint8_t> onStack(n, 0);
+        vector<pair<uint32_t, uint32_t>> calls;         // (atom, next edge)
+        component.assign(n, none);
+        uint32_t counter = 0, found = 0;
+        for (uint32_t s = 0; s < n; s++) {
+            if (index[s] != none) continue;
+            index[s] = low[s] = counter++;
+            stack.push_back(s);
+            onStack[s] = 1;
+            calls.push_back({ s, start[s] });
+            while (!calls.empty()) {
+                uint32_t v = calls.back().first;
+                uint32_t& e = calls.back().second;
+                if (e < start[v + 1]) {
+                    uint32_t w = target[e++];
+                    if (index[w] == none) {
+                        index[w] = low[w] = counter++;
+                        stack.push_back(w);
+                        onStack[w] = 1;
+                        calls.push_back({ w, start[w] });
+                    }
+                    else if (onStack[w]) {
+                        low[v] = min(low[v], index[w]);
+                    }
+                    continue;
+                }
+                if (low[v] == index[v]) {
+                    uint32_t w;
+                    do {
+                        w = stack.back();
+                        stack.pop_back();
+                        onStack[w] = 0;
+                        component[w] = found;
+                    } while (w != v);
+                    found++;
+                }
+                calls.pop_back();
+                if (!calls.empty()) {
+                    uint32_t parent = calls.back().first;
+                    low[parent] = min(low[parent], low[v]);
+                }
+            }
+        }
+
+        // Tarjan finishes sinks first; reverse so sources come first
+        for (auto& c : component) c = found - 1 - c;
+        recursive.assign(found, 0);
+        stratified = true;
+        for (uint32_t a = 0; a < n; a++) {
+            for (uint32_t e = start[a]; e < start[a + 1]; e++) {
+                if (component[target[e]] != component[a]) continue;
+                recursive[component[a]] = 1;
+                if (negative[e]) stratified = false;
+            }
+        }
+        planValid = true;
+    }
+
+    // One ordered pass over the components: the rules woken in a component
+    // run once, and only a recursive component repeats until it stops
+    // changing. Rules are keyed by their conclusion's component, so by the
+    // time a NOT is read the atom under it is final. A derived atom also
+    // withdraws what an earlier run concluded from its absence; those atoms
+    // lie in later components, so their rules are queued again and settle
+    // in order. Returns the facts derived; steps counts the components that
+    // ran.
+    size_t evaluateInOrder(const vector<uint32_t>& wave, const vector<uint32_t>& candidates,
+        int& steps, ostream* narration) {
+        priority_queue<uint64_t, vector<uint64_t>, greater<uint64_t>> pending;
+        uint32_t queued = ++stamp;
+        auto enqueue = [&](uint32_t r) {
+            if (ruleStamp[r] == queued) return;
+            ruleStamp[r] = queued;
+            pending.push((uint64_t)component[rules[r].conclusion] << 32 | r);
+        };
+        auto wake = [&](uint32_t a) {
+            for (uint32_t link = alphaHead[a]; link != none; link = linkNext[link]) enqueue(linkRule[link]);
+        };
+        for (uint32_t r : candidates) enqueue(r);
+        for (uint32_t a : wave) wake(a);
+
+        auto known = [&](uint32_t a) { return truth[a] == True; };
+        size_t derived = 0;
+        uint32_t current = none;
+        while (!pending.empty()) {
+            uint32_t c = (uint32_t)(pending.top() >> 32), r = (uint32_t)pending.top();
+            pending.pop();
+            ruleStamp[r] = 0;
+            if (c != current) {
+                current = c;
+                steps++;
+            }
+
+            const Rule& rule = rules[r];
+            if (truth[rule.conclusion] == True || !holds(rule, known)) continue;
+            derive(rule.conclusion, r);
+            derived++;
+            wake(rule.conclusion);
+            for (uint32_t x : withdrawNegated(rule.conclusion)) {
+                for (uint32_t q = firstRuleFor[x]; q != none; q = nextRuleFor[q]) enqueue(q);
+                wake(x);
+            }
+            if (narration) {
+                *narration << "  Component " << c << ": '" << conditionText(rule.condition)
+                    << "' - '" << atoms.name(rule.conclusion) << "'\n";
+            }
+        }
+        return derived;
+    }
+
+    // Ordered pass when the rule base is stratified, agenda loop otherwise
+    size_t propagate(vector<uint32_t> wave, vector<uint32_t> candidates, int& steps, ostream* narration) {
+        if (!planValid) buildPlan();
+        if (stratified) return evaluateInOrder(wave, candidates, steps, narration);
+        return saturate(move(wave), move(candidates), steps, narration);
+    }
+
+    // Condition in disjunctive normal form: terms of sorted literals
+    // (atom * 2 + negated), contradictory terms dropped. Returns false if it
+    // would need more than limit terms.
+    bool normalForm(uint32_t n, bool negated, vector<vector<uint32_t>>& terms, size_t limit) const {
+        const Node& x = nodes[n];
+        if (x.op == OpAtom) {
+            terms = { { x.a * 2 + negated } };
+            return true;
+        }
+        if (x.op == OpNot) return normalForm(x.a, !negated, terms, limit);
+
+        vector<vector<uint32_t>> left, right;
+        if (!normalForm(x.a, negated, left, limit) || !normalForm(x.b, negated, right, limit)) return false;
+        if ((x.op == OpOr) != negated) {
+            if (left.size() + right.size() > limit) return false;
+            terms = move(left);
+            terms.insert(terms.end(), right.begin(), right.end());
+            return true;
+        }
+
+        if (left.size() * right.size() > limit) return false;
+        terms.clear();
+        for (const auto& l : left) {
+            for (const auto& r : right) {
+                vector<uint32_t> t;
+                set_union(l.begin(), l.end(), r.begin(), r.end(), back_inserter(t));
+                bool contradictory = false;
+                for (size_t i = 1; i < t.size(); i++) contradictory |= t[i] == (t[i - 1] | 1);
+                if (!contradictory) terms.push_back(move(t));
+            }
+        }
+        return true;
+    }
+
+    // Every term of a is at least as strict as some term of b, so a implies b
+    static bool implies(const vector<vector<uint32_t>>& a, const vector<vector<uint32_t>>& b) {
+        for (const auto& ta : a) {
+            bool covered = false;
+            for (const auto& tb : b) {
+                if (includes(ta.begin(), ta.end(), tb.begin(), tb.end())) {
+                    covered = true;
+                    break;
+                }
+            }
+            if (!covered) return false;
+        }
+        return true;
+    }
+
+    // Text of register k of a rule's program, as conditionText would give it
+    string registerText(const Rule& rule, uint32_t k) const {
+        const Instr& in = code[rule.codeStart + k];
+        auto operand = [&](uint32_t j) {
+            Op op = code[rule.codeStart + j].op;
+            return op == OpAnd || op == OpOr ? "(" + registerText(rule, j) + ")" : registerText(rule, j);
+        };
+        switch (in.op) {
+        case OpAtom: return atoms.name(in.a);
+        case OpNot:  return "NOT " + operand(in.a);
+        default:     return operand(in.a) + (in.op == OpAnd ? " AND " : " OR ") + operand(in.b);
+        }
+    }
+
+    string ruleLabel(const Rule& rule) const {
+        return !rule.originalRule.empty() ? rule.originalRule :
+            "IF " + conditionText(rule.condition) + " THEN " + atoms.name(rule.conclusion);
+    }
+
+    void watch(uint32_t a, uint32_t rule) {
+        uint32_t link = (uint32_t)linkRule.size();
+        linkRule.push_back(rule);
+        linkNext.push_back(none);
+        if (alphaTail[a] == none) alphaHead[a] = link;
+        else linkNext[alphaTail[a]] = link;
+        alphaTail[a] = link;
+    }
+
+    // addFact by atom id. A new fact can break supports that read it under
+    // NOT; those conclusions are withdrawn, restored where another rule
+    // still holds, and the next infer() resumes from them.
+    void giveFact(uint32_t a, bool value) {
+        base[a] = 1;
+        if (!value) {
+            if (truth[a] == True) epoch++;
+            truth[a] = False;
+        }
+        else if (truth[a] != True) {
+            truth[a] = True;
+            madeTrue[a] = ++tick;
+            agenda.push_back(a);
+            epoch++;
+
+            vector<uint32_t> withdrawn = withdrawNegated(a);
+            rederive(withdrawn);
+            agenda.insert(agenda.end(), withdrawn.begin(), withdrawn.end());
+        }
+    }
+
+    // a has just become true: withdraws the derived atoms whose support rule
+    // no longer holds (it read a under NOT), with everything resting on them
+    vector<uint32_t> withdrawNegated(uint32_t a) {
+        vector<uint32_t> withdrawn;
+        auto known = [&](uint32_t x) { return truth[x] == True; };
+        for (uint32_t link = alphaHead[a]; link != none; link = linkNext[link]) {
+            uint32_t r = linkRule[link], c = rules[r].conclusion;
+            if (truth[c] != True || base[c] || support[c] != r || holds(rules[r], known)) continue;
+            truth[c] = Unknown;
+            support[c] = none;
+            withdrawn.push_back(c);
+        }
+        overdelete(withdrawn);
+        return withdrawn;
+    }
+
+    // Withdraws every derived atom whose recorded support rule mentions an
+    // atom already in withdrawn, transitively (DRed overdeletion)
+    void overdelete(vector<uint32_t>& withdrawn) {
+        for (size_t i = 0; i < withdrawn.size(); i++) {
+            for (uint32_t link = alphaHead[withdrawn[i]]; link != none; link = linkNext[link]) {
+                uint32_t c = rules[linkRule[link]].conclusion;
+                if (truth[c] != True || base[c] || support[c] != linkRule[link]) continue;
+                truth[c] = Unknown;
+                support[c] = none;
+                withdrawn.push_back(c);
+            }
+        }
+    }
+
+    // Restores the withdrawn atoms that another rule still gives
+    void rederive(const vector<uint32_t>& withdrawn) {
+        auto known = [&](uint32_t x) { return truth[x] == True; };
+        for (uint32_t x : withdrawn) {
+            for (uint32_t r = firstRuleFor[x]; r != none; r = nextRuleFor[r]) {
+                if (!holds(rules[r], known)) continue;
+                derive(x, r);
+                break;
+            }
+        }
+    }
+
+    void derive(uint32_t a, uint32_t rule) {
+        truth[a] = True;
+        support[a] = rule;
+        madeTrue[a] = ++tick;
+    }
+
+    // Registers a rule whose condition is already a DAG node
+    void addCompiledRule(uint32_t root, uint32_t conclusion, const string& desc, const string& original) {
+        uint32_t r = (uint32_t)rules.size();
+        Rule rule(root, conclusion, desc, original);
+        tie(rule.codeStart, rule.codeLength) = program(root);
+        rules.push_back(rule);
+        ruleStamp.push_back(0);
+        nextRuleFor.push_back(firstRuleFor[rule.conclusion]);
+        firstRuleFor[rule.conclusion] = r;
+        epoch++;
+        planValid = false;
+
+        // Wake the rule on any atom it mentions, negated or not
+        for (uint32_t i = 0; i < rule.codeLength; i++) {
+            const Instr& in = code[rule.codeStart + i];
+            if (in.op == OpAtom) watch(in.a, r);
+        }
+        freshRules.push_back(r);
+    }
+
 public:
+    // Narration for parseRule / infer
+    void setTraceSink(TraceSink& sink) { trace = &sink; }
+
     void addFact(const string& fact, bool value = true) {
-        facts[fact] = value;
+        giveFact(atom(fact), value);
     }
 
     bool isFact(const string& fact) const {
-        auto it = facts.find(fact);
-        return it != facts.end() && it->second;
+        uint32_t a = atoms.find(fact);
+        return a != none && truth[a] == True;
     }
 
+    // The condition may use AND / OR / NOT and parentheses; throws
+    // runtime_error if it does not parse
     void addRule(const string& condition, const string& conclusion,
         const string& desc = "", const string& original = "") {
-        rules.push_back(Rule(condition, conclusion, desc, original));
+        uint32_t root = compileCondition(condition);
+        addCompiledRule(root, atom(conclusion), desc, original);
     }
 
+    size_t ruleCount() const { return rules.size(); }
+    size_t atomCount() const { return atoms.size(); }
+    size_t conditionNodeCount() const { return nodes.size(); }
+
     // RULE PARSING 
     bool parseRule(const string& ruleString) {
-        cout << endl;
-        cout << "[INFO] Parsing: \"" << ruleString << "\"\n";
+        bool proof = trace->wants(TraceLevel::Proof);
+        if (proof) {
+            trace->stream() << "\n";
+            trace->stream() << "[INFO] Parsing: \"" << ruleString << "\"\n";
+        }
 
         // Find "IF" and "THEN"
         size_t ifPos = ruleString.find("IF ");
         size_t thenPos = ruleString.find(" THEN ");
 
         if (ifPos == string::npos || thenPos == string::npos) {
-            cout << "[ERROR] Invalid format! Use: IF <condition> THEN <conclusion>"<<endl;
+            if (trace->wants(TraceLevel::Summary)) {
+                trace->stream() << "[ERROR] Invalid format! Use: IF <condition> THEN <conclusion>" << "\n";
+                trace->flush();
+            }
             return false;
         }
 
@@ -68,12 +790,25 @@ public:
         conclusion.erase(0, conclusion.find_first_not_of(" \t"));
         conclusion.erase(conclusion.find_last_not_of(" \t") + 1);
 
-        // Convert to internal format (replace spaces with underscores)
-        replace(condition.begin(), condition.end(), ' ', '_');
+        // Convert to internal format (replace spaces with underscores);
+        // the condition is compiled word by word
         replace(conclusion.begin(), conclusion.end(), ' ', '_');
 
-        addRule(condition, conclusion, "Parsed rule", ruleString);
-        cout << "[SUCCESS] Parsed as: IF '" << condition << "' THEN '" << conclusion << "'\n";
+        try {
+            addRule(condition, conclusion, "Parsed rule", ruleString);
+        }
+        catch (const runtime_error& e) {
+            if (trace->wants(TraceLevel::Summary)) {
+                trace->stream() << "[ERROR] Invalid condition: " << e.what() << "\n";
+                trace->flush();
+            }
+            return false;
+        }
+        if (proof) {
+            trace->stream() << "[SUCCESS] Parsed as: IF '" << conditionText(rules.back().condition)
+                << "' THEN '" << conclusion << "'\n";
+            trace->flush();
+        }
         return true;
     }
 
@@ -201,69 +936,549 @@ public:
 
     // FORWARD CHAINING INFERENCE
     void infer() {
-        bool changed = true;
+        bool proof = trace->wants(TraceLevel::Proof);
+        bool summary = trace->wants(TraceLevel::Summary);
+        ostream& out = trace->stream();
+
+        if (proof) {
+            out << "\n";
+            out << "[INFO] Running inference engine..." << "\n";
+        }
+
+        vector<uint32_t> wave, candidates;
+        wave.swap(agenda);
+        candidates.swap(freshRules);
         int iteration = 0;
-        cout << endl;
-        cout << "[INFO] Running inference engine..."<<endl;
+        size_t derived = propagate(wave, candidates, iteration, proof ? &out : nullptr);
 
-        while (changed && iteration < 10) {
-            changed = false;
-            iteration++;
+        if (summary) {
+            if (derived == 0) {
+                out << "[INFO] No new facts inferred." << "\n";
+            }
+            else if (stratified) {
+                out << "[SUCCESS] Inference complete in one ordered pass over " << iteration
+                    << " rule groups (" << derived << " new facts)" << "\n";
+            }
+            else {
+                out << "[SUCCESS] Inference complete after " << (iteration - 1) << " iterations ("
+                    << derived << " new facts)" << "\n";
+            }
+        }
+        if (derived > 0) epoch++;
+        trace->flush();
+    }
+
+    // TRUTH MAINTENANCE
+    // Withdraws a fact given with addFact, DRed style: first every derived
+    // fact whose recorded support rule mentions a withdrawn atom is
+    // withdrawn too; then each of those that still has another rule whose
+    // condition holds is restored, and inference resumes from the restored
+    // atoms and from the withdrawn ones (which may enable NOT conditions).
+    // Work is proportional to the consequences of the fact, not the rule
+    // base. Returns how many facts stopped holding, 0 if the fact was not
+    // given.
+    size_t retractFact(const string& fact) {
+        uint32_t a = atoms.find(fact);
+        if (a == none || !base[a]) return 0;
+
+        base[a] = 0;
+        if (truth[a] == False) {
+            truth[a] = Unknown;
+            return 0;
+        }
+
+        // Overdelete, rederive from alternative rules, then resume inference
+        vector<uint32_t> withdrawn{ a };
+        truth[a] = Unknown;
+        overdelete(withdrawn);
+        rederive(withdrawn);
+        int iterations = 0;
+        propagate(withdrawn, {}, iterations, nullptr);
+        epoch++;
 
-            for (const auto& rule : rules) {
-                if (isFact(rule.condition) && !isFact(rule.conclusion)) {
-                    addFact(rule.conclusion);
-                    changed = true;
-                    cout << "  Iteration " << iteration << ": '" << rule.condition
-                        << "' - '" << rule.conclusion << "'\n";
+        size_t lost = 0;
+        for (uint32_t x : withdrawn) lost += truth[x] != True;
+        return lost;
+    }
+
+    bool isDerived(const string& fact) const {
+        uint32_t a = atoms.find(fact);
+        return a != none && truth[a] == True && support[a] != none;
+    }
+
+    // EXPLANATIONS
+    // Rebuilds why a fact holds from what inference recorded: the rule
+    // behind each derived atom and when the atom became true. A rule may
+    // justify an atom only through atoms that were true before it, and NOT
+    // only through atoms that were not, so the explanation cannot go in a
+    // circle. Among the rules that qualify, and the true branches of each
+    // OR, the one needing the fewest derivations is chosen. Steps come
+    // premises first and each fact appears once; empty if the fact does
+    // not hold.
+    vector<Justification> explain(const string& fact) {
+        vector<Justification> steps;
+        uint32_t g = atoms.find(fact);
+        if (g == none || truth[g] != True) return steps;
+
+        const uint64_t unreachable = UINT64_MAX / 4;
+        auto before = [&](uint32_t a, uint32_t limit) { return truth[a] == True && madeTrue[a] < limit; };
+
+        // Atoms that can appear: premises true before what they support
+        uint32_t mark = ++stamp;
+        vector<uint32_t> reach{ g };
+        atomStamp[g] = mark;
+        for (size_t i = 0; i < reach.size(); i++) {
+            uint32_t x = reach[i];
+            if (base[x]) continue;
+            for (uint32_t r = firstRuleFor[x]; r != none; r = nextRuleFor[r]) {
+                const Rule& rule = rules[r];
+                for (uint32_t k = 0; k < rule.codeLength; k++) {
+                    const Instr& in = code[rule.codeStart + k];
+                    if (in.op != OpAtom || atomStamp[in.a] == mark || !before(in.a, madeTrue[x])) continue;
+                    atomStamp[in.a] = mark;
+                    reach.push_back(in.a);
+                }
+            }
+        }
+        sort(reach.begin(), reach.end(), [&](uint32_t x, uint32_t y) { return madeTrue[x] < madeTrue[y]; });
+
+        // Cheapest justification per atom, premises before conclusions
+        unordered_map<uint32_t, pair<uint64_t, uint32_t>> best;         // atom -> (derivations, rule)
+        vector<uint8_t> value;
+        vector<uint64_t> cost;
+        auto evaluate = [&](const Rule& rule, uint32_t limit) {
+            const Instr* p = code.data() + rule.codeStart;
+            value.assign(rule.codeLength, 0);
+            cost.assign(rule.codeLength, unreachable);
+            for (uint32_t i = 0; i < rule.codeLength; i++) {
+                const Instr& in = p[i];
+                switch (in.op) {
+                case OpAtom:
+                    value[i] = before(in.a, limit);
+                    if (value[i]) cost[i] = best[in.a].first;
+                    break;
+                case OpNot:
+                    value[i] = !value[in.a];
+                    if (value[i]) cost[i] = 0;
+                    break;
+                case OpAnd:
+                    value[i] = value[in.a] & value[in.b];
+                    if (value[i]) cost[i] = min(unreachable, cost[in.a] + cost[in.b]);
+                    break;
+                case OpOr:
+                    value[i] = value[in.a] | value[in.b];
+                    cost[i] = min(value[in.a] ? cost[in.a] : unreachable, value[in.b] ? cost[in.b] : unreachable);
+                    break;
+                }
+            }
+            return cost[rule.codeLength - 1];
+        };
+        for (uint32_t x : reach) {
+            auto& choice = best[x];
+            choice = { base[x] ? 0 : unreachable, base[x] ? none : support[x] };
+            if (base[x]) continue;
+            for (uint32_t r = firstRuleFor[x]; r != none; r = nextRuleFor[r]) {
+                uint64_t c = evaluate(rules[r], madeTrue[x]);
+                if (c < unreachable && c + 1 < choice.first) choice = { c + 1, r };
+            }
+        }
+
+        // Walk the chosen rules back from the goal
+        atomStamp[g] = ++stamp;
+        vector<uint32_t> needed{ g };
+        for (size_t i = 0; i < needed.size(); i++) {
+            uint32_t x = needed[i];
+            Justification step{ atoms.name(x), "", {} };
+            uint32_t r = best[x].second;
+            if (r != none) {
+                const Rule& rule = rules[r];
+                step.rule = ruleLabel(rule);
+                evaluate(rule, madeTrue[x]);
+                const Instr* p = code.data() + rule.codeStart;
+                vector<uint32_t> open{ rule.codeLength - 1 };
+                while (!open.empty()) {
+                    uint32_t k = open.back();
+                    open.pop_back();
+                    const Instr& in = p[k];
+                    if (in.op == OpAtom) {
+                        const string& name = atoms.name(in.a);
+                        if (find(step.premises.begin(), step.premises.end(), name) == step.premises.end()) {
+                            step.premises.push_back(name);
+                        }
+                        if (atomStamp[in.a] != stamp) {
+                            atomStamp[in.a] = stamp;
+                            needed.push_back(in.a);
+                        }
+                    }
+                    else if (in.op == OpNot) {
+                        step.premises.push_back("NOT " + registerText(rule, in.a));
+                    }
+                    else if (in.op == OpAnd) {
+                        open.push_back(in.b);
+                        open.push_back(in.a);
+                    }
+                    else {
+                        bool left = value[in.a] && (!value[in.b] || cost[in.a] <= cost[in.b]);
+                        open.push_back(left ? in.a : in.b);
+                    }
                 }
             }
+            steps.push_back(move(step));
         }
 
-        if (iteration == 1) {
-            cout << "[INFO] No new facts inferred."<<endl;
+        vector<uint32_t> order(steps.size());
+        for (uint32_t i = 0; i < order.size(); i++) order[i] = i;
+        sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) { return madeTrue[needed[x]] < madeTrue[needed[y]]; });
+        vector<Justification> ordered;
+        for (uint32_t i : order) ordered.push_back(move(steps[i]));
+        return ordered;
+    }
+
+    // BACKWARD CHAINING
+    // Answers a single goal without running infer(): walks back from the
+    // goal through the rules that conclude it to collect the relevant slice
+    // of the rule base, then solves only that slice to fixpoint. Every atom
+    // in the slice is tabled, so later and overlapping queries reuse the
+    // answers until a fact or rule is added. Cycles end because each atom
+    // joins the slice once. Derived answers are not added to the facts.
+    // A stratified slice is solved in component order, as infer() does, so
+    // NOT only reads atoms whose component is finished.
+    bool query(const string& goal) {
+        uint32_t g = atoms.find(goal);
+        if (g == none) return false;
+        if (truth[g] == True) return true;
+        if (tableEpoch[g] == epoch) return tableValue[g];
+
+        uint32_t mark = ++stamp;
+        vector<uint32_t> stack{ g }, sliceRules;
+        atomStamp[g] = mark;
+        while (!stack.empty()) {
+            uint32_t a = stack.back();
+            stack.pop_back();
+            tableEpoch[a] = epoch;
+            tableValue[a] = 0;
+
+            for (uint32_t r = firstRuleFor[a]; r != none; r = nextRuleFor[r]) {
+                ruleStamp[r] = mark;
+                sliceRules.push_back(r);
+
+                const Rule& rule = rules[r];
+                for (uint32_t i = 0; i < rule.codeLength; i++) {
+                    const Instr& in = code[rule.codeStart + i];
+                    if (in.op != OpAtom || atomStamp[in.a] == mark) continue;
+                    atomStamp[in.a] = mark;
+                    if (truth[in.a] != True && tableEpoch[in.a] != epoch) stack.push_back(in.a);
+                }
+            }
         }
-        else {
-            cout << "[SUCCESS] Inference complete after " << (iteration - 1) << " iterations"<<endl;
+
+        // Fixpoint over the slice; only rules inside it are woken
+        auto value = [&](uint32_t a) {
+            return truth[a] == True || (tableEpoch[a] == epoch && tableValue[a]);
+        };
+        if (!planValid) buildPlan();
+        if (stratified) {
+            priority_queue<uint64_t, vector<uint64_t>, greater<uint64_t>> pending;
+            auto enqueue = [&](uint32_t r) { pending.push((uint64_t)component[rules[r].conclusion] << 32 | r); };
+            for (uint32_t r : sliceRules) enqueue(r);
+            while (!pending.empty()) {
+                const Rule& rule = rules[(uint32_t)pending.top()];
+                pending.pop();
+                if (value(rule.conclusion) || !holds(rule, value)) continue;
+
+                tableValue[rule.conclusion] = 1;
+                for (uint32_t link = alphaHead[rule.conclusion]; link != none; link = linkNext[link]) {
+                    if (ruleStamp[linkRule[link]] == mark) enqueue(linkRule[link]);
+                }
+            }
+            return tableValue[g];
+        }
+
+        vector<uint32_t> work(sliceRules.rbegin(), sliceRules.rend());
+        while (!work.empty()) {
+            const Rule& rule = rules[work.back()];
+            work.pop_back();
+            if (value(rule.conclusion) || !holds(rule, value)) continue;
+
+            tableValue[rule.conclusion] = 1;
+            for (uint32_t link = alphaHead[rule.conclusion]; link != none; link = linkNext[link]) {
+                if (ruleStamp[linkRule[link]] == mark) work.push_back(linkRule[link]);
+            }
         }
+        return tableValue[g];
     }
 
     // CONFLICT DETECTION
     vector<string> detectConflicts() {
         vector<string> conflicts;
 
-        for (const auto& fact : facts) {
-            if (!fact.second) continue;
+        for (uint32_t a = 0; a < atoms.size(); a++) {
+            const string& name = atoms.name(a);
+            if (truth[a] != True || name.compare(0, 4, "NOT_") != 0) continue;
 
-            string negation = "NOT_" + fact.first;
-            if (facts.find(negation) != facts.end() && facts[negation]) {
-                conflicts.push_back("Both '" + fact.first + "' and '" + negation + "' are true");
+            string positive = name.substr(4);
+            if (isFact(positive)) {
+                conflicts.push_back("Both '" + positive + "' and '" + name + "' are true");
             }
         }
 
-        for (size_t i = 0; i < rules.size(); i++) {
-            for (size_t j = i + 1; j < rules.size(); j++) {
-                if (rules[i].condition == rules[j].condition &&
-                    rules[i].conclusion != rules[j].conclusion) {
-                    conflicts.push_back("Same condition leads to different conclusions");
-                }
+        // Conditions are hash-consed, so equal conditions share a root node
+        unordered_map<uint32_t, uint32_t> firstConclusion;
+        unordered_set<uint32_t> reported;
+        for (const auto& rule : rules) {
+            auto it = firstConclusion.emplace(rule.condition, rule.conclusion).first;
+            if (it->second != rule.conclusion && reported.insert(rule.condition).second) {
+                conflicts.push_back("Same condition '" + conditionText(rule.condition) +
+                    "' leads to different conclusions");
             }
         }
 
+        ConsistencyReport report = checkConsistency();
+        if (!report.consistent) {
+            string core;
+            for (const auto& item : report.core) core += (core.empty() ? "" : "; ") + item;
+            conflicts.push_back("Rules and facts cannot all hold: " + core);
+        }
         return conflicts;
     }
 
+    // SAT CONSISTENCY CHECK
+    // Each rule becomes the clause (NOT condition OR conclusion), with one
+    // variable per condition node (Tseitin), each fact given with addFact a
+    // unit clause, and X / NOT_X are made mutually exclusive. Every rule and
+    // fact is guarded by its own selector literal, so an inconsistent answer
+    // comes with the rules and facts behind it, shrunk to a minimal core.
+    ConsistencyReport checkConsistency() const {
+        ConsistencyReport report;
+        SatSolver sat;
+        for (size_t a = 0; a < atoms.size(); a++) sat.newVar();
+
+        vector<int> nodeVar(nodes.size());
+        for (uint32_t n = 0; n < nodes.size(); n++) {
+            const Node& x = nodes[n];
+            if (x.op == OpAtom) {
+                nodeVar[n] = (int)x.a;
+                continue;
+            }
+            int v = sat.newVar();
+            nodeVar[n] = v;
+            int out = SatSolver::lit(v), a = SatSolver::lit(nodeVar[x.a]);
+            if (x.op == OpNot) {
+                sat.addClause({ SatSolver::negate(out), SatSolver::negate(a) });
+                sat.addClause({ out, a });
+                continue;
+            }
+            int b = SatSolver::lit(nodeVar[x.b]);
+            if (x.op == OpAnd) {
+                sat.addClause({ SatSolver::negate(out), a });
+                sat.addClause({ SatSolver::negate(out), b });
+                sat.addClause({ out, SatSolver::negate(a), SatSolver::negate(b) });
+            }
+            else {
+                sat.addClause({ SatSolver::negate(out), a, b });
+                sat.addClause({ out, SatSolver::negate(a) });
+                sat.addClause({ out, SatSolver::negate(b) });
+            }
+        }
+
+        for (uint32_t a = 0; a < atoms.size(); a++) {
+            const string& name = atoms.name(a);
+            if (name.compare(0, 4, "NOT_") != 0) continue;
+            uint32_t positive = atoms.find(name.substr(4));
+            if (positive != none) {
+                sat.addClause({ SatSolver::lit((int)a, true), SatSolver::lit((int)positive, true) });
+            }
+        }
+
+        // Selectors: one per rule, then one per given fact
+        vector<int> selectors;
+        vector<string> labels;
+        for (const auto& rule : rules) {
+            int s = SatSolver::lit(sat.newVar());
+            sat.addClause({ SatSolver::negate(s), SatSolver::lit(nodeVar[rule.condition], true),
+                SatSolver::lit((int)rule.conclusion) });
+            selectors.push_back(s);
+            labels.push_back(ruleLabel(rule));
+        }
+        for (uint32_t a = 0; a < atoms.size(); a++) {
+            if (!base[a] || truth[a] == Unknown) continue;
+            int s = SatSolver::lit(sat.newVar());
+            sat.addClause({ SatSolver::negate(s), SatSolver::lit((int)a, truth[a] == False) });
+            selectors.push_back(s);
+            labels.push_back(truth[a] == True ? "FACT " + atoms.name(a) : "FACT NOT " + atoms.name(a));
+        }
+        report.variables = sat.varCount();
+        report.clauses = sat.clauseCount();
+
+        if (sat.solve(selectors) == SatSolver::Satisfiable) return report;
+        report.consistent = false;
+
+        // Deletion-based shrinking: drop each selector the rest still refutes
+        vector<int> core = sat.failedAssumptions();
+        for (size_t i = 0; i < core.size() && core.size() <= 256;) {
+            vector<int> rest(core);
+            rest.erase(rest.begin() + i);
+            if (sat.solve(rest) == SatSolver::Unsatisfiable) {
+                const vector<int>& failed = sat.failedAssumptions();
+                if (failed.size() < rest.size()) {
+                    core = failed;
+                    i = 0;
+                }
+                else {
+                    core = rest;
+                }
+            }
+            else {
+                i++;
+            }
+        }
+
+        sort(core.begin(), core.end());
+        for (size_t i = 0; i < selectors.size(); i++) {
+            if (binary_search(core.begin(), core.end(), selectors[i])) report.core.push_back(labels[i]);
+        }
+        return report;
+    }
+
+    // RULE BASE ANALYSIS
+    // Builds the atom dependency graph and reports its cycles, strata, the
+    // rules whose condition can never hold given the current facts, the
+    // rules implied by another rule with the same conclusion, and the order
+    // infer() evaluates rules in.
+    RuleAnalysis analyzeRules() {
+        RuleAnalysis report;
+        buildPlan();
+        size_t n = atoms.size();
+        size_t components = recursive.size();
+        report.stratified = stratified;
+
+        // Cycles and stratum numbers, walking atoms in component order
+        vector<uint32_t> order(n);
+        for (uint32_t a = 0; a < n; a++) order[a] = a;
+        stable_sort(order.begin(), order.end(), [&](uint32_t x, uint32_t y) { return component[x] < component[y]; });
+        vector<vector<string>> members(components);
+        for (uint32_t a : order) {
+            if (recursive[component[a]]) members[component[a]].push_back(atoms.name(a));
+        }
+        for (auto& m : members) {
+            if (!m.empty()) report.cycles.push_back(move(m));
+        }
+
+        vector<uint32_t> stratum(components, 0);
+        vector<uint32_t> byComponent(rules.size());
+        for (uint32_t r = 0; r < rules.size(); r++) byComponent[r] = r;
+        stable_sort(byComponent.begin(), byComponent.end(), [&](uint32_t x, uint32_t y) {
+            return component[rules[x].conclusion] < component[rules[y].conclusion];
+        });
+        for (uint32_t r : byComponent) {
+            uint32_t c = component[rules[r].conclusion];
+            for (const auto& lit : literals(rules[r])) {
+                uint32_t from = component[lit.first];
+                bool negated = (lit.second & 2) != 0;
+                if (from == c && negated) report.negativeCycles.push_back(ruleLabel(rules[r]));
+                if (from != c) stratum[c] = max(stratum[c], stratum[from] + (negated ? 1 : 0));
+            }
+            report.evaluationOrder.push_back(ruleLabel(rules[r]));
+        }
+        for (uint32_t s : stratum) report.strata = max<size_t>(report.strata, s + 1);
+
+        // Possible truth: an atom can hold if it is a fact or some rule
+        // concluding it can fire; a negated atom can hold unless it is a fact
+        vector<uint8_t> possible(n, 0);
+        vector<uint32_t> work;
+        for (uint32_t a = 0; a < n; a++) {
+            if (truth[a] == True) {
+                possible[a] = 1;
+                work.push_back(a);
+            }
+        }
+        vector<uint8_t> canTrue, canFalse;
+        auto canFire = [&](const Rule& rule) {
+            const Instr* p = code.data() + rule.codeStart;
+            canTrue.assign(rule.codeLength, 0);
+            canFalse.assign(rule.codeLength, 0);
+            for (uint32_t i = 0; i < rule.codeLength; i++) {
+                const Instr& in = p[i];
+                switch (in.op) {
+                case OpAtom:
+                    canTrue[i] = possible[in.a];
+                    canFalse[i] = !(base[in.a] && truth[in.a] == True);
+                    break;
+                case OpNot:
+                    canTrue[i] = canFalse[in.a];
+                    canFalse[i] = canTrue[in.a];
+                    break;
+                case OpAnd:
+                    canTrue[i] = canTrue[in.a] & canTrue[in.b];
+                    canFalse[i] = canFalse[in.a] | canFalse[in.b];
+                    break;
+                case OpOr:
+                    canTrue[i] = canTrue[in.a] | canTrue[in.b];
+                    canFalse[i] = canFalse[in.a] & canFalse[in.b];
+                    break;
+                }
+            }
+            return canTrue[rule.codeLength - 1] != 0;
+        };
+        for (uint32_t r = 0; r < rules.size(); r++) {
+            if (!possible[rules[r].conclusion] && canFire(rules[r])) {
+                possible[rules[r].conclusion] = 1;
+                work.push_back(rules[r].conclusion);
+            }
+        }
+        while (!work.empty()) {
+            uint32_t a = work.back();
+            work.pop_back();
+            for (uint32_t link = alphaHead[a]; link != none; link = linkNext[link]) {
+                const Rule& rule = rules[linkRule[link]];
+                if (possible[rule.conclusion] || !canFire(rule)) continue;
+                possible[rule.conclusion] = 1;
+                work.push_back(rule.conclusion);
+            }
+        }
+
+        // Subsumption within each group of rules sharing a conclusion; of
+        // equivalent rules the first one is kept
+        const size_t limit = 64;
+        vector<uint8_t> dead(rules.size(), 0);
+        for (uint32_t a = 0; a < n; a++) {
+            vector<uint32_t> group;
+            for (uint32_t r = firstRuleFor[a]; r != none; r = nextRuleFor[r]) group.push_back(r);
+            reverse(group.begin(), group.end());
+
+            vector<vector<vector<uint32_t>>> forms(group.size());
+            vector<uint8_t> known(group.size(), 0);
+            for (size_t i = 0; i < group.size(); i++) {
+                known[i] = normalForm(rules[group[i]].condition, false, forms[i], limit);
+                dead[group[i]] = !canFire(rules[group[i]]) || (known[i] && forms[i].empty());
+            }
+            for (size_t j = 0; j < group.size(); j++) {
+                if (!known[j] || dead[group[j]]) continue;
+                for (size_t i = 0; i < group.size(); i++) {
+                    if (i == j || !known[i] || dead[group[i]] || !implies(forms[j], forms[i])) continue;
+                    if (i > j && implies(forms[i], forms[j])) continue;
+                    report.subsumedRules.push_back(ruleLabel(rules[group[j]]) +
+                        " (implied by " + ruleLabel(rules[group[i]]) + ")");
+                    break;
+                }
+            }
+        }
+        for (uint32_t r = 0; r < rules.size(); r++) {
+            if (dead[r]) report.deadRules.push_back(ruleLabel(rules[r]));
+        }
+        return report;
+    }
+
     void displayFacts() const {
         cout << endl;
         cout << "[INFO] Known Facts:"<<endl;
-        int count = 0;
-        for (const auto& f : facts) {
-            if (f.second) {
-                cout << "  - " << f.first << endl;
-                count++;
-            }
+        vector<string> known;
+        for (uint32_t a = 0; a < atoms.size(); a++) {
+            if (truth[a] == True) known.push_back(atoms.name(a));
         }
-        if (count == 0) cout << "  (No facts established)"<<endl;
+        sort(known.begin(), known.end());
+        for (const auto& f : known) cout << "  - " << f << endl;
+        if (known.empty()) cout << "  (No facts established)"<<endl;
     }
 
     void displayRules() const {
@@ -275,15 +1490,22 @@ public:
                 cout << rules[i].originalRule;
             }
             else {
-                cout << "IF " << rules[i].condition << " THEN " << rules[i].conclusion;
+                cout << "IF " << conditionText(rules[i].condition) << " THEN " << atoms.name(rules[i].conclusion);
             }
             cout << endl;
         }
         if (rules.empty()) cout << "  (No rules defined)" << endl;
     }
 
+    // Runs the rules for every student at once (defined in Population.h)
+    static void evaluatePopulation(LogicEngine& engine, const vector<Student>& students);
+
+    // Prompts for a rule file and bulk-loads it (defined in RuleLoader.h)
+    static void loadRuleFile(LogicEngine& engine);
+
     // MODULE MENU
-    static void showMenu(const vector<Faculty>& faculties,
+    static void showMenu(const vector<Student>& students,
+        const vector<Faculty>& faculties,
         const vector<Course>& courses,
         const vector<Room>& rooms) {
         LogicEngine engine;
@@ -302,6 +1524,13 @@ public:
             cout << "  6. Run Inference Engine"<<endl;
             cout << "  7. Check for Conflicts"<<endl;
             cout << "  8. Run Demonstration"<<endl;
+            cout << "  9. Run Datalog Demonstration"<<endl;
+            cout << "  10. Query a Fact (backward chaining)"<<endl;
+            cout << "  11. Retract a Fact"<<endl;
+            cout << "  12. Analyze Rule Base"<<endl;
+            cout << "  13. Explain a Fact"<<endl;
+            cout << "  14. Evaluate Rules for All Students"<<endl;
+            cout << "  15. Load Rule File"<<endl;
             cout << "  0. Back to Main Menu"<<endl<<endl;
             cout << "  Choice: ";
 
@@ -358,6 +1587,78 @@ public:
             case 8:
                 demonstrate();
                 break;
+            case 9:
+                DatalogEngine::demonstrate();
+                break;
+            case 10: {
+                cout << endl;
+                cout << "Enter fact to query: ";
+                string goal;
+                getline(cin, goal);
+                replace(goal.begin(), goal.end(), ' ', '_');
+                cout << (engine.query(goal) ? "[SUCCESS] '" + goal + "' holds" : "[INFO] '" + goal + "' cannot be derived") << endl;
+                break;
+            }
+            case 11: {
+                cout << endl;
+                cout << "Enter fact to retract: ";
+                string fact;
+                getline(cin, fact);
+                replace(fact.begin(), fact.end(), ' ', '_');
+                size_t lost = engine.retractFact(fact);
+                cout << "[INFO] " << lost << " fact(s) no longer hold" << endl;
+                engine.displayFacts();
+                break;
+            }
+            case 12: {
+                auto report = engine.analyzeRules();
+                cout << endl;
+                cout << "[INFO] " << report.strata << " strata, "
+                    << (report.stratified ? "stratified" : "NOT stratified") << endl;
+                for (const auto& cycle : report.cycles) {
+                    cout << "  Cycle:";
+                    for (const auto& a : cycle) cout << " " << a;
+                    cout << endl;
+                }
+                for (const auto& r : report.negativeCycles) cout << "  Negation in a cycle: " << r << endl;
+                for (const auto& r : report.deadRules) cout << "  Dead: " << r << endl;
+                for (const auto& r : report.subsumedRules) cout << "  Subsumed: " << r << endl;
+                cout << "[INFO] Evaluation order:" << endl;
+                for (size_t i = 0; i < report.evaluationOrder.size(); i++) {
+                    cout << "  " << (i + 1) << ". " << report.evaluationOrder[i] << endl;
+                }
+                break;
+            }
+            case 13: {
+                cout << endl;
+                cout << "Enter fact to explain: ";
+                string fact;
+                getline(cin, fact);
+                replace(fact.begin(), fact.end(), ' ', '_');
+                auto steps = engine.explain(fact);
+                if (steps.empty()) {
+                    cout << "[INFO] '" << fact << "' does not hold" << endl;
+                    break;
+                }
+                cout << "[INFO] Why '" << fact << "' holds:" << endl;
+                for (const auto& step : steps) {
+                    cout << "  - " << step.fact;
+                    if (step.rule.empty()) {
+                        cout << " (given)" << endl;
+                        continue;
+                    }
+                    cout << " by " << step.rule << ", from";
+                    for (const auto& p : step.premises) cout << " " << p << ";";
+                    cout << endl;
+                }
+                break;
+            }
+            case 14:
+                evaluatePopulation(engine, students);
+                break;
+            case 15:
+                loadRuleFile(engine);
+                break;
             default:
                 cout << "[ERROR] Invalid choice!"<<endl;
             }
@@ -379,6 +1680,7 @@ public:
         engine.parseRule("IF ProfX teaches CS101 THEN Lab must be LabA");
         engine.parseRule("IF Lab must be LabA THEN LabA reserved");
         engine.parseRule("IF CS101 offered THEN CS101 has schedule");
+        engine.parseRule("IF CS101 has schedule AND (LabA reserved OR NOT CS101 needs lab) THEN CS101 open");
 
         engine.addFact("ProfX_teaches_CS101");
         engine.addFact("CS101_offered");
@@ -398,4 +1700,8 @@ public:
     }
 };
 
+// Menu options defined with the modules they use
+#include "Population.h"
+#include "RuleLoader.h"
+
 #endif
\ No newline at end of file
@@ -183,6 +183,7 @@ public:
 
         if (student && course) {
             student->enrollCourse(courseId);
+            EnrollmentEvents::enrolled(studentId, courseId);
             CLI::displaySuccess(student->getName() + " enrolled in " + course->getName());
         }
         else {
@@ -449,7 +450,7 @@ int main() {
             break;
 
         case 4:
-            LogicEngine::showMenu(dataStore.faculties, dataStore.courses, dataStore.rooms);
+            LogicEngine::showMenu(dataStore.students, dataStore.faculties, dataStore.courses, dataStore.rooms);
             break;
 
         case 5:
@@ -0,0 +1,42 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+using namespace std;
+
+// Worker count for n items, keeping at least minPerWorker items per worker
+inline unsigned workerCount(size_t n, size_t minPerWorker = 1, unsigned requested = 0) {
+    unsigned hw = requested ? requested : thread::hardware_concurrency();
+    if (hw == 0) hw = 1;
+    size_t byWork = minPerWorker ? n / minPerWorker : n;
+    return (unsigned)max<size_t>(1, min<size_t>(hw, byWork));
+}
+
+// Runs fn(begin, end, worker) over contiguous chunks of [0, n).
+// Chunks are handed out in order, so worker w always covers indices
+// before those of worker w + 1. The calling thread runs the last chunk.
+template <typename Fn>
+void parallelFor(size_t n, unsigned workers, Fn fn) {
+    if (workers <= 1 || n < 2) {
+        fn((size_t)0, n, 0u);
+        return;
+    }
+
+    size_t chunk = (n + workers - 1) / workers;
+    vector<thread> pool;
+    pool.reserve(workers - 1);
+
+    for (unsigned w = 0; w + 1 < workers; w++) {
+        size_t begin = min(n, w * chunk);
+        size_t end = min(n, begin + chunk);
+        pool.emplace_back([=, &fn]() { fn(begin, end, w); });
+    }
+    size_t last = workers - 1;
+    fn(min(n, last * chunk), n, (unsigned)last);
+
+    for (auto& t : pool) t.join();
+}
+
+#endif
@@ -0,0 +1,325 @@
+#ifndef POPULATION_H
+#define POPULATION_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include "Bits.h"
+#include "Interner.h"
+#include "Parallel.h"
+#include "Logic.h"
+using namespace std;
+
+// Population Evaluator
+// Runs a LogicEngine's rules for every student at once. Each fact is a
+// column bitmap with one bit per student, and each rule is compiled into
+// word operations (LOAD / NOT / AND / OR / ANDNOT) over those columns.
+// Students are processed in blocks of BlockWords words; within a block every
+// instruction is a straight loop over the words. Rules run grouped by the
+// engine's component order, as infer() does: a group runs once, or until the
+// block stops changing if it is recursive, so a column is final before any
+// later rule reads it under NOT. Blocks are independent, so they are spread
+// over worker threads. Rule bases with NOT inside a cycle are rejected.
+class PopulationEvaluator {
+private:
+    static constexpr size_t BlockWords = 64;
+
+    enum WordOp : uint8_t { Load, Not, And, Or, AndNot };
+
+    struct WordInstr {
+        WordOp op;
+        uint32_t a, b;                  // Load: atom id; otherwise registers
+    };
+
+    struct CompiledRule {
+        uint32_t start, length;
+        uint32_t conclusion;
+        uint32_t component;
+    };
+
+    struct Group {
+        uint32_t begin, end;            // range of compiled
+        bool recursive;
+    };
+
+    IdInterner studentIds;
+    IdInterner atomIds;
+    vector<vector<uint64_t>> columns;   // by atom, one bit per student
+    vector<vector<uint64_t>> given;     // the facts set before run()
+    vector<WordInstr> code;
+    vector<CompiledRule> compiled;     // in component order
+    vector<Group> groups;
+    vector<pair<uint32_t, uint32_t>> exclusive;         // (X, NOT_X) atom pairs
+    size_t maxLength = 0;
+
+    size_t words() const { return (studentIds.size() + 63) / 64; }
+
+    static void setBit(vector<uint64_t>& column, size_t row) {
+        if (column.size() <= row / 64) column.resize(row / 64 + 1, 0);
+        column[row / 64] |= 1ULL << (row % 64);
+    }
+
+    static bool testBit(const vector<uint64_t>& column, size_t row) {
+        return row / 64 < column.size() && (column[row / 64] >> (row % 64) & 1);
+    }
+
+    // Translates one engine program, fusing AND with a NOT operand into
+    // ANDNOT and dropping the instructions nothing reads afterwards
+    void compile(const LogicEngine& engine, const LogicEngine::Rule& rule) {
+        const LogicEngine::Instr* p = engine.code.data() + rule.codeStart;
+        uint32_t n = rule.codeLength;
+
+        vector<WordInstr> raw(n);
+        for (uint32_t i = 0; i < n; i++) {
+            const auto& in = p[i];
+            switch (in.op) {
+            case LogicEngine::OpAtom: raw[i] = { Load, in.a, 0 }; break;
+            case LogicEngine::OpNot:  raw[i] = { Not, in.a, 0 }; break;
+            case LogicEngine::OpOr:   raw[i] = { Or, in.a, in.b }; break;
+            case LogicEngine::OpAnd:
+                if (p[in.b].op == LogicEngine::OpNot) raw[i] = { AndNot, in.a, p[in.b].a };
+                else if (p[in.a].op == LogicEngine::OpNot) raw[i] = { AndNot, in.b, p[in.a].a };
+                else raw[i] = { And, in.a, in.b };
+                break;
+            }
+        }
+
+        vector<char> live(n, 0);
+        live[n - 1] = 1;
+        for (uint32_t i = n; i-- > 0;) {
+            if (!live[i] || raw[i].op == Load) continue;
+            live[raw[i].a] = 1;
+            if (raw[i].op != Not) live[raw[i].b] = 1;
+        }
+
+        vector<uint32_t> reg(n);
+        uint32_t start = (uint32_t)code.size();
+        for (uint32_t i = 0; i < n; i++) {
+            if (!live[i]) continue;
+            WordInstr w = raw[i];
+            if (w.op != Load) {
+                w.a = reg[w.a];
+                if (w.op != Not) w.b = reg[w.b];
+            }
+            reg[i] = (uint32_t)code.size() - start;
+            code.push_back(w);
+        }
+        uint32_t length = (uint32_t)code.size() - start;
+        maxLength = max<size_t>(maxLength, length);
+        compiled.push_back({ start, length, rule.conclusion, engine.component[rule.conclusion] });
+    }
+
+    // Ors one rule's result into its conclusion; returns whether anything was new
+    bool runRule(const CompiledRule& rule, size_t w0, size_t count, vector<uint64_t>& scratch,
+        vector<const uint64_t*>& regs) {
+        size_t lastWord = words() - 1;
+        uint64_t tailMask = studentIds.size() % 64 ? (1ULL << (studentIds.size() % 64)) - 1 : ~0ULL;
+
+        const WordInstr* p = code.data() + rule.start;
+        for (uint32_t i = 0; i < rule.length; i++) {
+            if (p[i].op == Load) {
+                regs[i] = columns[p[i].a].data() + w0;
+                continue;
+            }
+            uint64_t* dst = scratch.data() + i * BlockWords;
+            const uint64_t* a = regs[p[i].a];
+            const uint64_t* b = p[i].op == Not ? nullptr : regs[p[i].b];
+            switch (p[i].op) {
+            case Not:    for (size_t k = 0; k < count; k++) dst[k] = ~a[k]; break;
+            case And:    for (size_t k = 0; k < count; k++) dst[k] = a[k] & b[k]; break;
+            case Or:     for (size_t k = 0; k < count; k++) dst[k] = a[k] | b[k]; break;
+            case AndNot: for (size_t k = 0; k < count; k++) dst[k] = a[k] & ~b[k]; break;
+            default: break;
+            }
+            regs[i] = dst;
+        }
+
+        const uint64_t* result = regs[rule.length - 1];
+        uint64_t* target = columns[rule.conclusion].data() + w0;
+        uint64_t added = 0;
+        for (size_t k = 0; k < count; k++) {
+            uint64_t fresh = result[k] & ~target[k];
+            if (w0 + k == lastWord) fresh &= tailMask;
+            target[k] |= fresh;
+            added |= fresh;
+        }
+        return added != 0;
+    }
+
+    // Groups in order over words [w0, w0 + count)
+    void runBlock(size_t w0, size_t count, vector<uint64_t>& scratch, vector<const uint64_t*>& regs) {
+        for (const auto& group : groups) {
+            bool changed;
+            do {
+                changed = false;
+                for (uint32_t r = group.begin; r < group.end; r++) changed |= runRule(compiled[r], w0, count, scratch, regs);
+            } while (changed && group.recursive);
+        }
+    }
+
+public:
+    // Snapshots the engine's atoms, compiled rules and evaluation order
+    // (building the plan if needed); throws if NOT is read inside a cycle
+    explicit PopulationEvaluator(LogicEngine& engine) {
+        if (!engine.planValid) engine.buildPlan();
+        if (!engine.stratified) throw runtime_error("Rules with NOT inside a cycle cannot be evaluated in order");
+
+        atomIds = engine.atoms;
+        columns.resize(atomIds.size());
+        given.resize(atomIds.size());
+        for (const auto& rule : engine.rules) compile(engine, rule);
+
+        stable_sort(compiled.begin(), compiled.end(), [](const CompiledRule& x, const CompiledRule& y) {
+            return x.component < y.component;
+        });
+        for (uint32_t r = 0; r < compiled.size(); r++) {
+            if (groups.empty() || compiled[groups.back().begin].component != compiled[r].component) {
+                groups.push_back({ r, r, engine.recursive[compiled[r].component] != 0 });
+            }
+            groups.back().end = r + 1;
+        }
+
+        for (uint32_t a = 0; a < atomIds.size(); a++) {
+            const string& name = atomIds.name(a);
+            if (name.compare(0, 4, "NOT_") != 0) continue;
+            uint32_t positive = atomIds.find(name.substr(4));
+            if (positive != IdInterner::npos) exclusive.push_back({ positive, a });
+        }
+    }
+
+    size_t addStudent(const string& student) {
+        return studentIds.intern(student);
+    }
+
+    // Facts the rules never mention are ignored (returns false)
+    bool setFact(const string& student, const string& fact) {
+        size_t row = addStudent(student);
+        uint32_t a = atomIds.find(fact);
+        if (a == IdInterner::npos) return false;
+        setBit(columns[a], row);
+        setBit(given[a], row);
+        return true;
+    }
+
+    // Same as setFact for a whole column of students
+    void setFacts(const string& fact, const vector<string>& students) {
+        uint32_t a = atomIds.find(fact);
+        for (const auto& s : students) {
+            size_t row = addStudent(s);
+            if (a == IdInterner::npos) continue;
+            setBit(columns[a], row);
+            setBit(given[a], row);
+        }
+    }
+
+    void run(unsigned threads = 0) {
+        size_t n = words();
+        for (auto& column : columns) column.resize(n, 0);
+        if (n == 0 || compiled.empty()) return;
+
+        size_t blocks = (n + BlockWords - 1) / BlockWords;
+        unsigned workers = workerCount(blocks, 4, threads);
+        parallelFor(blocks, workers, [&](size_t begin, size_t end, unsigned) {
+            vector<uint64_t> scratch(maxLength * BlockWords);
+            vector<const uint64_t*> regs(maxLength);
+            for (size_t b = begin; b < end; b++) {
+                size_t w0 = b * BlockWords;
+                runBlock(w0, min(BlockWords, n - w0), scratch, regs);
+            }
+        });
+    }
+
+    size_t studentCount() const { return studentIds.size(); }
+
+    bool holds(const string& student, const string& fact) const {
+        uint32_t row = studentIds.find(student);
+        uint32_t a = atomIds.find(fact);
+        return row != IdInterner::npos && a != IdInterner::npos && testBit(columns[a], row);
+    }
+
+    // Students for whom the fact holds after run()
+    size_t count(const string& fact) const {
+        uint32_t a = atomIds.find(fact);
+        if (a == IdInterner::npos) return 0;
+        size_t total = 0;
+        for (uint64_t w : columns[a]) total += popcount64(w);
+        return total;
+    }
+
+    vector<string> derivedFacts(const string& student) const {
+        vector<string> facts;
+        uint32_t row = studentIds.find(student);
+        if (row == IdInterner::npos) return facts;
+        for (uint32_t a = 0; a < atomIds.size(); a++) {
+            if (testBit(columns[a], row) && !testBit(given[a], row)) facts.push_back(atomIds.name(a));
+        }
+        return facts;
+    }
+
+    vector<string> conflicts(const string& student) const {
+        vector<string> found;
+        uint32_t row = studentIds.find(student);
+        if (row == IdInterner::npos) return found;
+        for (const auto& pair : exclusive) {
+            if (testBit(columns[pair.first], row) && testBit(columns[pair.second], row)) {
+                found.push_back("Both '" + atomIds.name(pair.first) + "' and '" +
+                    atomIds.name(pair.second) + "' are true");
+            }
+        }
+        return found;
+    }
+
+    // Students with at least one X / NOT_X conflict
+    vector<string> conflictedStudents() const {
+        vector<uint64_t> any(words(), 0);
+        for (const auto& pair : exclusive) {
+            const auto& x = columns[pair.first];
+            const auto& y = columns[pair.second];
+            for (size_t w = 0; w < min(x.size(), y.size()); w++) any[w] |= x[w] & y[w];
+        }
+        vector<string> students;
+        for (size_t row = 0; row < studentIds.size(); row++) {
+            if (testBit(any, row)) students.push_back(studentIds.name((uint32_t)row));
+        }
+        return students;
+    }
+};
+
+// Logic menu: each student's record is given as completed_<course> facts,
+// the rules run for the whole roster, and the derived facts are counted
+inline void LogicEngine::evaluatePopulation(LogicEngine& engine, const vector<Student>& students) {
+    cout << endl;
+    if (engine.rules.empty() || students.empty()) {
+        cout << "[ERROR] Need at least one rule and one student!" << endl;
+        return;
+    }
+    unique_ptr<PopulationEvaluator> population;
+    try {
+        population.reset(new PopulationEvaluator(engine));
+    }
+    catch (const runtime_error& e) {
+        cout << "[ERROR] " << e.what() << endl;
+        return;
+    }
+    for (const auto& s : students) {
+        population->addStudent(s.getId());
+        for (const auto& c : s.getCourses()) population->setFact(s.getId(), "completed_" + c);
+    }
+    population->run();
+
+    cout << "[INFO] Rules evaluated for " << population->studentCount() << " student(s)" << endl;
+    for (uint32_t a = 0; a < engine.atoms.size(); a++) {
+        const string& fact = engine.atoms.name(a);
+        if (fact.compare(0, 10, "completed_") == 0) continue;
+        size_t holding = population->count(fact);
+        if (holding > 0) cout << "  " << fact << ": " << holding << " student(s)" << endl;
+    }
+    for (const auto& s : population->conflictedStudents()) {
+        for (const auto& c : population->conflicts(s)) cout << "  [CONFLICT] " << s << ": " << c << endl;
+    }
+}
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef PREREQUISITE_GRAPH_H
+#define PREREQUISITE_GRAPH_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <cstdint>
+#include "Interner.h"
+using namespace std;
+
+// Prerequisite Graph
+// Read-only, interned snapshot of a prerequisite map. Adjacency is stored in
+// compressed (CSR) form in both directions so algorithms can walk it without
+// touching strings.
+class PrerequisiteGraph {
+private:
+    IdInterner ids;
+    vector<uint32_t> prereqStart, prereqList;
+    vector<uint32_t> dependentStart, dependentList;
+
+public:
+    struct Range {
+        const uint32_t* first;
+        const uint32_t* last;
+        const uint32_t* begin() const { return first; }
+        const uint32_t* end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+    };
+
+    static PrerequisiteGraph build(const map<string, set<string>>& prerequisites,
+        const set<string>& extraCourses = {}) {
+        PrerequisiteGraph g;
+        for (const auto& c : extraCourses) g.ids.intern(c);
+        for (const auto& entry : prerequisites) {
+            g.ids.intern(entry.first);
+            for (const auto& p : entry.second) g.ids.intern(p);
+        }
+
+        size_t n = g.ids.size();
+        vector<vector<uint32_t>> reqs(n);
+        for (const auto& entry : prerequisites) {
+            uint32_t c = g.ids.find(entry.first);
+            for (const auto& p : entry.second) reqs[c].push_back(g.ids.find(p));
+        }
+
+        g.prereqStart.assign(n + 1, 0);
+        g.dependentStart.assign(n + 1, 0);
+        for (uint32_t c = 0; c < n; c++) {
+            g.prereqStart[c + 1] = g.prereqStart[c] + (uint32_t)reqs[c].size();
+            for (uint32_t p : reqs[c]) g.dependentStart[p + 1]++;
+        }
+        for (size_t c = 0; c < n; c++) g.dependentStart[c + 1] += g.dependentStart[c];
+
+        g.prereqList.reserve(g.prereqStart[n]);
+        g.dependentList.resize(g.dependentStart[n]);
+        vector<uint32_t> fill(g.dependentStart.begin(), g.dependentStart.end() - 1);
+        for (uint32_t c = 0; c < n; c++) {
+            for (uint32_t p : reqs[c]) {
+                g.prereqList.push_back(p);
+                g.dependentList[fill[p]++] = c;
+            }
+        }
+        return g;
+    }
+
+    size_t size() const { return ids.size(); }
+    size_t edgeCount() const { return prereqList.size(); }
+
+    uint32_t id(const string& course) const { return ids.find(course); }
+    const string& name(uint32_t course) const { return ids.name(course); }
+
+    Range prerequisitesOf(uint32_t course) const {
+        return { prereqList.data() + prereqStart[course],
+            prereqList.data() + prereqStart[course + 1] };
+    }
+
+    Range dependentsOf(uint32_t course) const {
+        return { dependentList.data() + dependentStart[course],
+            dependentList.data() + dependentStart[course + 1] };
+    }
+};
+
+#endif
@@ -6,21 +6,60 @@
 #include <iostream>
 #include <limits>
 #include <vector>
+#include <algorithm>
 #include "BaseClasses.h"
+#include "BitRelation.h"
 using namespace std;
 
 // Relations
+// Pairs are kept in a set; property checks and closure run on a bit matrix
+// over the domain (element i is the i-th smallest), built on first use and
+// rebuilt after the relation changes. The matrix takes n^2 / 8 bytes, so it
+// is only used while that stays under 64 MB and within 64 bytes per pair;
+// large sparse relations are checked on the pairs and their successor lists.
 template <typename T>
 class Relations {
 private:
     set<pair<T, T>> relations;
     set<T> domain;
+    mutable BitRelation matrix;
+    mutable bool matrixReady = false;
+
+    static constexpr size_t matrixLimit = (size_t)64 << 20;
+
+    bool useMatrix() const {
+        size_t n = domain.size();
+        if (n > 1 << 24) return false;
+        size_t bytes = n * ((n + 63) / 64) * 8;
+        return bytes <= min(matrixLimit, max<size_t>((size_t)1 << 20, 64 * relations.size()));
+    }
+
+    map<T, vector<T>> successors() const {
+        map<T, vector<T>> next;
+        for (const auto& rel : relations) next[rel.first].push_back(rel.second);
+        return next;
+    }
+
+    const BitRelation& bitMatrix() const {
+        if (matrixReady) return matrix;
+        vector<T> elements(domain.begin(), domain.end());
+        auto indexOf = [&](const T& x) { return (size_t)(lower_bound(elements.begin(), elements.end(), x) - elements.begin()); };
+        matrix = BitRelation(elements.size());
+        size_t from = 0;                // pairs come sorted by first element
+        for (const auto& rel : relations) {
+            if (elements[from] < rel.first) from = indexOf(rel.first);
+            matrix.add(from, indexOf(rel.second));
+        }
+        matrixReady = true;
+        return matrix;
+    }
 
 public:
     void addRelation(T a, T b) {
         relations.insert({ a, b });
         domain.insert(a);
         domain.insert(b);
+        matrixReady = false;
     }
 
     bool hasRelation(T a, T b) const {
@@ -31,6 +70,7 @@ public:
     set<T> getDomain() const { return domain; }
 
     bool isReflexive() const {
+        if (useMatrix()) return bitMatrix().isReflexive();
         for (const auto& elem : domain) {
             if (!hasRelation(elem, elem)) return false;
         }
@@ -38,6 +78,7 @@ public:
     }
 
     bool isSymmetric() const {
+        if (useMatrix()) return bitMatrix().isSymmetric();
         for (const auto& rel : relations) {
             if (!hasRelation(rel.second, rel.first)) return false;
         }
@@ -45,16 +86,49 @@ public:
     }
 
     bool isTransitive() const {
-        for (const auto& r1 : relations) {
-            for (const auto& r2 : relations) {
-                if (r1.second == r2.first) {
-                    if (!hasRelation(r1.first, r2.second)) return false;
-                }
+        if (useMatrix()) return bitMatrix().isTransitive();
+        auto next = successors();
+        for (const auto& rel : relations) {
+            auto it = next.find(rel.second);
+            if (it == next.end()) continue;
+            for (const auto& c : it->second) {
+                if (!hasRelation(rel.first, c)) return false;
             }
         }
         return true;
     }
 
+    // Smallest transitive relation containing this one: Warshall on the bit
+    // matrix, or a search from every element over the successor lists
+    Relations<T> transitiveClosure() const {
+        vector<T> elements(domain.begin(), domain.end());
+        Relations<T> result;
+        result.domain = domain;
+        if (useMatrix()) {
+            result.matrix = bitMatrix().transitiveClosure();
+            result.matrixReady = true;
+            result.matrix.forEachPair([&](size_t i, size_t j) {
+                result.relations.emplace_hint(result.relations.end(), elements[i], elements[j]);
+            });
+            return result;
+        }
+
+        auto next = successors();
+        for (const auto& entry : next) {
+            set<T> reached;
+            vector<T> stack(entry.second.begin(), entry.second.end());
+            while (!stack.empty()) {
+                T x = stack.back();
+                stack.pop_back();
+                if (!reached.insert(x).second) continue;
+                auto it = next.find(x);
+                if (it != next.end()) stack.insert(stack.end(), it->second.begin(), it->second.end());
+            }
+            for (const auto& x : reached) result.relations.emplace_hint(result.relations.end(), entry.first, x);
+        }
+        return result;
+    }
+
     bool isEquivalenceRelation() const {
         return isReflexive() && isSymmetric() && isTransitive();
     }
@@ -567,6 +641,14 @@ public:
         cout << endl;
         cout << "[SUCCESS] Prerequisite Relation (Partial Order):"<<endl;
         prereq.display();
+
+        Relations<string> direct;
+        direct.addRelation("CS101", "CS201");
+        direct.addRelation("CS201", "CS301");
+        direct.addRelation("CS301", "CS401");
+        cout << endl;
+        cout << "[SUCCESS] Transitive Closure of Direct Prerequisites:"<<endl;
+        direct.transitiveClosure().display();
         cout << endl;
         cout << "[SUCCESS] Module 6 Complete!"<<endl;
     }
@@ -0,0 +1,482 @@
+#ifndef ROARING_BITMAP_H
+#define ROARING_BITMAP_H
+
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+#include <cstdint>
+#include "Bits.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ROARING_SSE2 1
+#endif
+using namespace std;
+
+// Compressed Bitmap
+// Roaring-style set of 32-bit ids (interned student / course ids). The high
+// 16 bits of an id pick a container, which holds the low 16 bits as
+//   - an array: sorted values, while there are at most 4096 of them
+//   - a bitmap: 1024 words, for denser containers
+//   - runs: (start, length - 1) pairs, chosen by runOptimize() when smaller
+// Operations pair up containers by key; bitmap kernels combine 128 bits at
+// a time with SSE2 and count with popcount, and every container keeps its
+// cardinality, so size() is a sum over the containers.
+class RoaringBitmap {
+private:
+    enum Kind : uint8_t { Array, Bitmap, Run };
+    enum WordOp { WordAnd, WordOr, WordAndNot };
+
+    static constexpr uint32_t arrayLimit = 4096;
+    static constexpr size_t bitmapWords = 1024;
+
+    struct Container {
+        Kind kind = Array;
+        uint32_t cardinality = 0;
+        vector<uint16_t> values;        // Array: sorted values; Run: start, length - 1, ...
+        vector<uint64_t> words;         // Bitmap
+    };
+
+    vector<uint16_t> keys;              // sorted high halves
+    vector<Container> containers;
+
+    // CONTAINER HELPERS
+    static uint64_t rangeMask(uint32_t lo, uint32_t hi) {      // bits lo..hi of one word
+        uint64_t upper = hi == 63 ? ~0ULL : (1ULL << (hi + 1)) - 1;
+        return upper & ~((1ULL << lo) - 1);
+    }
+
+    static void setRange(vector<uint64_t>& w, uint32_t first, uint32_t last, bool on) {
+        for (uint32_t word = first / 64; word <= last / 64; word++) {
+            uint32_t lo = word == first / 64 ? first % 64 : 0;
+            uint32_t hi = word == last / 64 ? last % 64 : 63;
+            if (on) w[word] |= rangeMask(lo, hi);
+            else w[word] &= ~rangeMask(lo, hi);
+        }
+    }
+
+    static uint32_t countWords(const vector<uint64_t>& w) {
+        uint32_t total = 0;
+        for (uint64_t x : w) total += (uint32_t)popcount64(x);
+        return total;
+    }
+
+    // dst = dst op src over a whole bitmap container; returns the new cardinality
+    static uint32_t combineWords(vector<uint64_t>& dst, const vector<uint64_t>& src, WordOp op) {
+        uint64_t* d = dst.data();
+        const uint64_t* s = src.data();
+#ifdef ROARING_SSE2
+        for (size_t i = 0; i < bitmapWords; i += 2) {
+            __m128i x = _mm_loadu_si128((const __m128i*)(d + i));
+            __m128i y = _mm_loadu_si128((const __m128i*)(s + i));
+            __m128i r = op == WordAnd ? _mm_and_si128(x, y) : op == WordOr ? _mm_or_si128(x, y) : _mm_andnot_si128(y, x);
+            _mm_storeu_si128((__m128i*)(d + i), r);
+        }
+#else
+        for (size_t i = 0; i < bitmapWords; i++) {
+            d[i] = op == WordAnd ? d[i] & s[i] : op == WordOr ? d[i] | s[i] : d[i] & ~s[i];
+        }
+#endif
+        return countWords(dst);
+    }
+
+    static bool has(const Container& c, uint16_t v) {
+        if (c.kind == Bitmap) return c.words[v / 64] >> (v % 64) & 1;
+        if (c.kind == Array) return binary_search(c.values.begin(), c.values.end(), v);
+
+        // Last run starting at or before v
+        size_t lo = 0, hi = c.values.size() / 2;
+        while (lo < hi) {
+            size_t mid = (lo + hi) / 2;
+            if (c.values[2 * mid] <= v) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo > 0 && v <= (uint32_t)c.values[2 * (lo - 1)] + c.values[2 * (lo - 1) + 1];
+    }
+
+    static vector<uint64_t> bitsOf(const Container& c) {
+        if (c.kind == Bitmap) return c.words;
+        vector<uint64_t> w(bitmapWords, 0);
+        if (c.kind == Array) {
+            for (uint16_t v : c.values) w[v / 64] |= 1ULL << (v % 64);
+        }
+        else {
+            for (size_t i = 0; i < c.values.size(); i += 2) {
+                setRange(w, c.values[i], (uint32_t)c.values[i] + c.values[i + 1], true);
+            }
+        }
+        return w;
+    }
+
+    static Container fromBits(vector<uint64_t> w, uint32_t cardinality) {
+        Container c;
+        c.cardinality = cardinality;
+        if (cardinality > arrayLimit) {
+            c.kind = Bitmap;
+            c.words = move(w);
+            return c;
+        }
+        c.values.reserve(cardinality);
+        for (size_t i = 0; i < bitmapWords; i++) {
+            for (uint64_t x = w[i]; x; x &= x - 1) c.values.push_back((uint16_t)(i * 64 + ctz64(x)));
+        }
+        return c;
+    }
+
+    static Container fromArray(vector<uint16_t> values) {
+        Container c;
+        c.cardinality = (uint32_t)values.size();
+        if (c.cardinality <= arrayLimit) {
+            c.values = move(values);
+            return c;
+        }
+        c.kind = Bitmap;
+        c.words.assign(bitmapWords, 0);
+        for (uint16_t v : values) c.words[v / 64] |= 1ULL << (v % 64);
+        return c;
+    }
+
+    static Container fromRuns(vector<uint16_t> runs) {
+        Container c;
+        c.kind = Run;
+        for (size_t i = 1; i < runs.size(); i += 2) c.cardinality += runs[i] + 1u;
+        c.values = move(runs);
+        return c;
+    }
+
+    // Appends [first, last] to a run list, merging with the last run when they touch
+    static void appendRun(vector<uint16_t>& runs, uint32_t first, uint32_t last) {
+        if (!runs.empty()) {
+            uint32_t end = (uint32_t)runs[runs.size() - 2] + runs.back();
+            if (first <= end + 1) {
+                if (last > end) runs.back() = (uint16_t)(last - runs[runs.size() - 2]);
+                return;
+            }
+        }
+        runs.push_back((uint16_t)first);
+        runs.push_back((uint16_t)(last - first));
+    }
+
+    // CONTAINER OPERATIONS
+    static Container intersect(const Container& a, const Container& b) {
+        if (a.kind == Array && b.kind == Array) {
+            vector<uint16_t> out;
+            out.reserve(min(a.values.size(), b.values.size()));
+            set_intersection(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), back_inserter(out));
+            return fromArray(move(out));
+        }
+        if (a.kind == Array || b.kind == Array) {
+            const Container& arr = a.kind == Array ? a : b;
+            const Container& other = a.kind == Array ? b : a;
+            vector<uint16_t> out;
+            for (uint16_t v : arr.values) {
+                if (has(other, v)) out.push_back(v);
+            }
+            return fromArray(move(out));
+        }
+        if (a.kind == Run && b.kind == Run) {
+            vector<uint16_t> out;
+            size_t i = 0, j = 0;
+            while (i < a.values.size() && j < b.values.size()) {
+                uint32_t aEnd = (uint32_t)a.values[i] + a.values[i + 1];
+                uint32_t bEnd = (uint32_t)b.values[j] + b.values[j + 1];
+                uint32_t first = max(a.values[i], b.values[j]), last = min(aEnd, bEnd);
+                if (first <= last) appendRun(out, first, last);
+                if (aEnd < bEnd) i += 2;
+                else j += 2;
+            }
+            return fromRuns(move(out));
+        }
+        vector<uint64_t> w = bitsOf(a);
+        uint32_t count = combineWords(w, b.kind == Bitmap ? b.words : bitsOf(b), WordAnd);
+        return fromBits(move(w), count);
+    }
+
+    static Container unite(const Container& a, const Container& b) {
+        if (a.kind == Array && b.kind == Array) {
+            vector<uint16_t> out;
+            out.reserve(a.values.size() + b.values.size());
+            set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), back_inserter(out));
+            return fromArray(move(out));
+        }
+        if (a.kind == Run && b.kind == Run) {
+            vector<uint16_t> out;
+            size_t i = 0, j = 0;
+            while (i < a.values.size() || j < b.values.size()) {
+                bool takeA = j >= b.values.size() || (i < a.values.size() && a.values[i] <= b.values[j]);
+                const vector<uint16_t>& v = takeA ? a.values : b.values;
+                size_t& k = takeA ? i : j;
+                appendRun(out, v[k], (uint32_t)v[k] + v[k + 1]);
+                k += 2;
+            }
+            return fromRuns(move(out));
+        }
+        const Container& dense = a.kind == Bitmap ? a : b;
+        const Container& other = a.kind == Bitmap ? b : a;
+        vector<uint64_t> w = bitsOf(dense);
+        uint32_t count;
+        if (other.kind == Array) {
+            for (uint16_t v : other.values) w[v / 64] |= 1ULL << (v % 64);
+            count = countWords(w);
+        }
+        else {
+            count = combineWords(w, other.kind == Bitmap ? other.words : bitsOf(other), WordOr);
+        }
+        return fromBits(move(w), count);
+    }
+
+    static Container subtract(const Container& a, const Container& b) {
+        if (a.kind == Array) {
+            vector<uint16_t> out;
+            if (b.kind == Array) {
+                set_difference(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(), back_inserter(out));
+            }
+            else {
+                for (uint16_t v : a.values) {
+                    if (!has(b, v)) out.push_back(v);
+                }
+            }
+            return fromArray(move(out));
+        }
+        vector<uint64_t> w = bitsOf(a);
+        uint32_t count;
+        if (b.kind == Array) {
+            for (uint16_t v : b.values) w[v / 64] &= ~(1ULL << (v % 64));
+            count = countWords(w);
+        }
+        else if (b.kind == Run) {
+            for (size_t i = 0; i < b.values.size(); i += 2) setRange(w, b.values[i], (uint32_t)b.values[i] + b.values[i + 1], false);
+            count = countWords(w);
+        }
+        else {
+            count = combineWords(w, b.words, WordAndNot);
+        }
+        return fromBits(move(w), count);
+    }
+
+    // |a AND b| without building the result when both are bitmaps
+    static uint32_t intersectCount(const Container& a, const Container& b) {
+        if (a.kind != Bitmap || b.kind != Bitmap) return intersect(a, b).cardinality;
+        uint32_t total = 0;
+        for (size_t i = 0; i < bitmapWords; i++) total += (uint32_t)popcount64(a.words[i] & b.words[i]);
+        return total;
+    }
+
+    size_t find(uint16_t key) const {
+        return lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+    }
+
+    void push(uint16_t key, Container c) {
+        if (c.cardinality == 0) return;
+        keys.push_back(key);
+        containers.push_back(move(c));
+    }
+
+public:
+    RoaringBitmap() = default;
+
+    RoaringBitmap(initializer_list<uint32_t> ids) {
+        for (uint32_t id : ids) add(id);
+    }
+
+    explicit RoaringBitmap(vector<uint32_t> ids) {
+        sort(ids.begin(), ids.end());
+        ids.erase(unique(ids.begin(), ids.end()), ids.end());
+        for (size_t i = 0; i < ids.size();) {
+            uint16_t key = (uint16_t)(ids[i] >> 16);
+            vector<uint16_t> low;
+            for (; i < ids.size() && (uint16_t)(ids[i] >> 16) == key; i++) low.push_back((uint16_t)ids[i]);
+            push(key, fromArray(move(low)));
+        }
+    }
+
+    bool add(uint32_t id) {
+        uint16_t key = (uint16_t)(id >> 16), low = (uint16_t)id;
+        size_t at = find(key);
+        if (at == keys.size() || keys[at] != key) {
+            keys.insert(keys.begin() + at, key);
+            containers.insert(containers.begin() + at, Container());
+        }
+        Container& c = containers[at];
+        if (has(c, low)) return false;
+
+        if (c.kind == Run) c = fromBits(bitsOf(c), c.cardinality);
+        if (c.kind == Array) {
+            c.values.insert(lower_bound(c.values.begin(), c.values.end(), low), low);
+            c = fromArray(move(c.values));
+        }
+        else {
+            c.words[low / 64] |= 1ULL << (low % 64);
+            c.cardinality++;
+        }
+        return true;
+    }
+
+    bool remove(uint32_t id) {
+        uint16_t key = (uint16_t)(id >> 16), low = (uint16_t)id;
+        size_t at = find(key);
+        if (at == keys.size() || keys[at] != key || !has(containers[at], low)) return false;
+
+        Container& c = containers[at];
+        if (c.kind == Array) {
+            c.values.erase(lower_bound(c.values.begin(), c.values.end(), low));
+            c.cardinality--;
+        }
+        else {
+            vector<uint64_t> w = bitsOf(c);
+            w[low / 64] &= ~(1ULL << (low % 64));
+            c = fromBits(move(w), c.cardinality - 1);
+        }
+        if (c.cardinality == 0) {
+            keys.erase(keys.begin() + at);
+            containers.erase(containers.begin() + at);
+        }
+        return true;
+    }
+
+    bool contains(uint32_t id) const {
+        uint16_t key = (uint16_t)(id >> 16);
+        size_t at = find(key);
+        return at < keys.size() && keys[at] == key && has(containers[at], (uint16_t)id);
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& c : containers) total += c.cardinality;
+        return total;
+    }
+
+    bool empty() const { return containers.empty(); }
+
+    // Switches each container to runs where that is smaller
+    void runOptimize() {
+        for (auto& c : containers) {
+            vector<uint16_t> runs;
+            if (c.kind == Array) {
+                for (uint16_t v : c.values) appendRun(runs, v, v);
+            }
+            else if (c.kind == Bitmap) {
+                uint32_t v = 0;
+                while (v < 65536) {
+                    if (!(c.words[v / 64] >> (v % 64) & 1)) {
+                        v++;
+                        continue;
+                    }
+                    uint32_t start = v;
+                    while (v < 65536 && (c.words[v / 64] >> (v % 64) & 1)) v++;
+                    appendRun(runs, start, v - 1);
+                }
+            }
+            else {
+                continue;
+            }
+            size_t current = c.kind == Array ? 2 * c.values.size() : 8 * bitmapWords;
+            if (2 * runs.size() < current) c = fromRuns(move(runs));
+        }
+    }
+
+    // Approximate heap footprint
+    size_t sizeInBytes() const {
+        size_t total = keys.size() * sizeof(uint16_t) + containers.size() * sizeof(Container);
+        for (const auto& c : containers) total += c.values.size() * sizeof(uint16_t) + c.words.size() * sizeof(uint64_t);
+        return total;
+    }
+
+    vector<uint32_t> toVector() const {
+        vector<uint32_t> ids;
+        ids.reserve(size());
+        for (size_t k = 0; k < keys.size(); k++) {
+            uint32_t high = (uint32_t)keys[k] << 16;
+            const Container& c = containers[k];
+            if (c.kind == Array) {
+                for (uint16_t v : c.values) ids.push_back(high | v);
+            }
+            else if (c.kind == Run) {
+                for (size_t i = 0; i < c.values.size(); i += 2) {
+                    for (uint32_t v = c.values[i]; v <= (uint32_t)c.values[i] + c.values[i + 1]; v++) ids.push_back(high | v);
+                }
+            }
+            else {
+                for (size_t i = 0; i < bitmapWords; i++) {
+                    for (uint64_t x = c.words[i]; x; x &= x - 1) ids.push_back(high | (uint32_t)(i * 64 + ctz64(x)));
+                }
+            }
+        }
+        return ids;
+    }
+
+    bool operator==(const RoaringBitmap& other) const {
+        return keys == other.keys && toVector() == other.toVector();
+    }
+
+    static RoaringBitmap unionOf(const RoaringBitmap& a, const RoaringBitmap& b) {
+        RoaringBitmap r;
+        size_t i = 0, j = 0;
+        while (i < a.keys.size() || j < b.keys.size()) {
+            if (j == b.keys.size() || (i < a.keys.size() && a.keys[i] < b.keys[j])) {
+                r.push(a.keys[i], a.containers[i]);
+                i++;
+            }
+            else if (i == a.keys.size() || b.keys[j] < a.keys[i]) {
+                r.push(b.keys[j], b.containers[j]);
+                j++;
+            }
+            else {
+                r.push(a.keys[i], unite(a.containers[i], b.containers[j]));
+                i++;
+                j++;
+            }
+        }
+        return r;
+    }
+
+    static RoaringBitmap intersectionOf(const RoaringBitmap& a, const RoaringBitmap& b) {
+        RoaringBitmap r;
+        size_t i = 0, j = 0;
+        while (i < a.keys.size() && j < b.keys.size()) {
+            if (a.keys[i] < b.keys[j]) i++;
+            else if (b.keys[j] < a.keys[i]) j++;
+            else {
+                r.push(a.keys[i], intersect(a.containers[i], b.containers[j]));
+                i++;
+                j++;
+            }
+        }
+        return r;
+    }
+
+    static RoaringBitmap differenceOf(const RoaringBitmap& a, const RoaringBitmap& b) {
+        RoaringBitmap r;
+        size_t j = 0;
+        for (size_t i = 0; i < a.keys.size(); i++) {
+            while (j < b.keys.size() && b.keys[j] < a.keys[i]) j++;
+            if (j < b.keys.size() && b.keys[j] == a.keys[i]) r.push(a.keys[i], subtract(a.containers[i], b.containers[j]));
+            else r.push(a.keys[i], a.containers[i]);
+        }
+        return r;
+    }
+
+    // a is a subset of b
+    static bool isSubset(const RoaringBitmap& a, const RoaringBitmap& b) {
+        size_t j = 0;
+        for (size_t i = 0; i < a.keys.size(); i++) {
+            while (j < b.keys.size() && b.keys[j] < a.keys[i]) j++;
+            if (j == b.keys.size() || b.keys[j] != a.keys[i]) return false;
+            if (a.containers[i].cardinality > b.containers[j].cardinality) return false;
+            if (intersectCount(a.containers[i], b.containers[j]) != a.containers[i].cardinality) return false;
+        }
+        return true;
+    }
+
+    // |a AND b| without materializing bitmap-bitmap results
+    static size_t intersectionSize(const RoaringBitmap& a, const RoaringBitmap& b) {
+        size_t total = 0, i = 0, j = 0;
+        while (i < a.keys.size() && j < b.keys.size()) {
+            if (a.keys[i] < b.keys[j]) i++;
+            else if (b.keys[j] < a.keys[i]) j++;
+            else total += intersectCount(a.containers[i++], b.containers[j++]);
+        }
+        return total;
+    }
+};
+
+#endif
@@ -0,0 +1,440 @@
+#ifndef RULE_LOADER_H
+#define RULE_LOADER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstdint>
+#include "Parallel.h"
+#include "Logic.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+// Rule File Loader
+// Bulk-loads rule files into a LogicEngine. One entry per line:
+//   IF <condition> THEN <conclusion>
+//   FACT <name>          FACT NOT <name>
+//   # comment
+// The file is memory-mapped (read into memory where mmap is unavailable)
+// and split at line boundaries into chunks that are parsed in parallel.
+// Parsing works on string_views into the file: each chunk numbers its
+// atoms locally and keeps conditions as postfix code. Chunk atom names are
+// then normalized and looked up among the engine's existing atoms in
+// parallel too; the serial merge only interns atoms that are new to the
+// engine and builds the condition DAG. Malformed lines are reported with
+// their line number and skipped.
+class RuleFileLoader {
+public:
+    struct LineError {
+        size_t line;
+        string message;
+    };
+
+    struct Report {
+        size_t lines = 0;
+        size_t rules = 0;
+        size_t facts = 0;
+        vector<LineError> errors;
+    };
+
+private:
+    // Read-only view of a whole file
+    class MappedFile {
+    private:
+        const char* bytes = nullptr;
+        size_t length = 0;
+        bool mapped = false;
+        string copy;
+
+    public:
+        explicit MappedFile(const string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd >= 0) {
+                struct stat info;
+                bool empty = false;
+                if (fstat(fd, &info) == 0) {
+                    empty = info.st_size == 0;
+                    void* p = empty ? MAP_FAILED : mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (p != MAP_FAILED) {
+                        bytes = (const char*)p;
+                        length = (size_t)info.st_size;
+                        mapped = true;
+                    }
+                }
+                ::close(fd);
+                if (mapped || empty) return;
+            }
+#endif
+            ifstream in(path, ios::binary);
+            if (!in) throw runtime_error("cannot open '" + path + "'");
+            ostringstream text;
+            text << in.rdbuf();
+            copy = text.str();
+            bytes = copy.data();
+            length = copy.size();
+        }
+
+        ~MappedFile() {
+#if defined(__unix__) || defined(__APPLE__)
+            if (mapped) munmap((void*)bytes, length);
+#endif
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        string_view view() const { return string_view(bytes, length); }
+    };
+
+    enum Code : uint32_t { CodeAtom = 0, CodeNot = 1u << 30, CodeAnd = 2u << 30, CodeOr = 3u << 30 };
+    static constexpr uint32_t operandMask = (1u << 30) - 1;
+
+    enum Kind : uint8_t { KindRule, KindFact, KindNegatedFact };
+
+    struct Entry {
+        Kind kind;
+        uint32_t atom;                  // conclusion or fact, chunk-local
+        uint32_t start, length;         // postfix code of the condition
+    };
+
+    // What one worker produced for its share of the lines
+    struct Chunk {
+        string text;                    // distinct atoms as written, back to back
+        vector<uint32_t> textStart{ 0 };        // local atom id -> offset in text
+        vector<uint64_t> slots;         // open addressing: hash << 32 | (id + 1), 0 if empty
+        vector<uint32_t> code;
+        vector<Entry> entries;
+        vector<LineError> errors;       // line numbers relative to the chunk
+        size_t lines = 0;
+        vector<string> names;           // local atom id -> engine atom name
+        vector<uint32_t> global;        // local atom id -> engine atom id, or npos if new
+
+        size_t atomCount() const { return textStart.size() - 1; }
+
+        string_view atomText(uint32_t id) const {
+            return string_view(text).substr(textStart[id], textStart[id + 1] - textStart[id]);
+        }
+
+        // Linear probing on a table kept at most half full; the names are
+        // compared in the compact text rather than in the file
+        uint32_t intern(string_view span) {
+            if (slots.size() < 2 * (atomCount() + 1)) grow();
+            uint32_t hash = (uint32_t)(std::hash<string_view>()(span) >> 16);
+            size_t mask = slots.size() - 1;
+            for (size_t i = hash & mask;; i = (i + 1) & mask) {
+                uint64_t slot = slots[i];
+                if (slot == 0) {
+                    uint32_t id = (uint32_t)atomCount();
+                    slots[i] = (uint64_t)hash << 32 | (id + 1);
+                    text.append(span);
+                    textStart.push_back((uint32_t)text.size());
+                    return id;
+                }
+                uint32_t id = (uint32_t)slot - 1;
+                if ((uint32_t)(slot >> 32) == hash && atomText(id) == span) return id;
+            }
+        }
+
+        void grow() {
+            vector<uint64_t> old(max<size_t>(64, slots.size() * 2), 0);
+            old.swap(slots);
+            size_t mask = slots.size() - 1;
+            for (uint64_t slot : old) {
+                if (slot == 0) continue;
+                size_t i = (slot >> 32) & mask;
+                while (slots[i] != 0) i = (i + 1) & mask;
+                slots[i] = slot;
+            }
+        }
+    };
+
+    struct SyntaxError {
+        string message;
+    };
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    static bool isKeyword(string_view t) {
+        return t == "AND" || t == "OR" || t == "NOT" || t == "(" || t == ")" || t == "THEN";
+    }
+
+    static void tokenize(string_view line, vector<string_view>& tokens) {
+        tokens.clear();
+        size_t i = 0;
+        while (i < line.size()) {
+            char c = line[i];
+            if (isSpace(c)) {
+                i++;
+            }
+            else if (c == '(' || c == ')') {
+                tokens.push_back(line.substr(i, 1));
+                i++;
+            }
+            else {
+                size_t j = i;
+                while (j < line.size() && !isSpace(line[j]) && line[j] != '(' && line[j] != ')') j++;
+                tokens.push_back(line.substr(i, j - i));
+                i = j;
+            }
+        }
+    }
+
+    // Recursive descent over one line's tokens, same grammar as
+    // LogicEngine's condition compiler, emitting postfix code
+    class LineParser {
+    private:
+        Chunk& chunk;
+        const vector<string_view>& t;
+        size_t pos;
+
+    public:
+        LineParser(Chunk& chunk, const vector<string_view>& tokens, size_t pos)
+            : chunk(chunk), t(tokens), pos(pos) {
+        }
+
+        size_t position() const { return pos; }
+
+        // A run of plain words is one atom; its key is the span as written
+        uint32_t atom() {
+            if (pos >= t.size() || isKeyword(t[pos])) {
+                throw SyntaxError{ pos >= t.size() ? "expected a name" : "unexpected '" + string(t[pos]) + "'" };
+            }
+            const char* first = t[pos].data();
+            size_t last = pos;
+            while (last + 1 < t.size() && !isKeyword(t[last + 1])) last++;
+            string_view span(first, t[last].data() + t[last].size() - first);
+            pos = last + 1;
+
+            return chunk.intern(span);
+        }
+
+        void parseOr() {
+            parseAnd();
+            while (pos < t.size() && t[pos] == "OR") {
+                pos++;
+                parseAnd();
+                chunk.code.push_back(CodeOr);
+            }
+        }
+
+        void parseAnd() {
+            parseUnary();
+            while (pos < t.size() && t[pos] == "AND") {
+                pos++;
+                parseUnary();
+                chunk.code.push_back(CodeAnd);
+            }
+        }
+
+        void parseUnary() {
+            if (pos >= t.size()) throw SyntaxError{ "condition ends unexpectedly" };
+            if (t[pos] == "NOT") {
+                pos++;
+                parseUnary();
+                chunk.code.push_back(CodeNot);
+                return;
+            }
+            if (t[pos] == "(") {
+                pos++;
+                parseOr();
+                if (pos >= t.size() || t[pos] != ")") throw SyntaxError{ "missing ')'" };
+                pos++;
+                return;
+            }
+            chunk.code.push_back(CodeAtom | atom());
+        }
+    };
+
+    static void parseLine(Chunk& chunk, string_view line, vector<string_view>& tokens) {
+        tokenize(line, tokens);
+        if (tokens.empty() || tokens[0][0] == '#') return;
+
+        size_t mark = chunk.code.size();
+        try {
+            if (tokens[0] == "FACT") {
+                bool negated = tokens.size() > 1 && tokens[1] == "NOT";
+                LineParser parser(chunk, tokens, negated ? 2 : 1);
+                uint32_t a = parser.atom();
+                if (parser.position() != tokens.size()) {
+                    throw SyntaxError{ "unexpected '" + string(tokens[parser.position()]) + "'" };
+                }
+                chunk.entries.push_back({ negated ? KindNegatedFact : KindFact, a, 0, 0 });
+                return;
+            }
+            if (tokens[0] != "IF") throw SyntaxError{ "expected IF <condition> THEN <conclusion> or FACT <name>" };
+
+            LineParser parser(chunk, tokens, 1);
+            parser.parseOr();
+            size_t pos = parser.position();
+            if (pos >= tokens.size() || tokens[pos] != "THEN") {
+                throw SyntaxError{ pos < tokens.size() ? "unexpected '" + string(tokens[pos]) + "'" : "missing THEN" };
+            }
+
+            // The conclusion is every remaining word, joined like a fact name
+            if (pos + 1 >= tokens.size()) throw SyntaxError{ "missing conclusion" };
+            const char* first = tokens[pos + 1].data();
+            uint32_t conclusion = chunk.intern(string_view(first, tokens.back().data() + tokens.back().size() - first));
+            chunk.entries.push_back({ KindRule, conclusion, (uint32_t)mark, (uint32_t)(chunk.code.size() - mark) });
+        }
+        catch (const SyntaxError& e) {
+            chunk.code.resize(mark);
+            chunk.errors.push_back({ chunk.lines, e.message });
+        }
+    }
+
+    static void parseChunk(Chunk& chunk, string_view text) {
+        vector<string_view> tokens;
+        size_t i = 0;
+        while (i < text.size()) {
+            size_t end = text.find('\n', i);
+            if (end == string_view::npos) end = text.size();
+            chunk.lines++;
+            parseLine(chunk, text.substr(i, end - i), tokens);
+            i = end + 1;
+        }
+    }
+
+    // Words separated by any whitespace are joined with '_', as parseRule does
+    static string atomName(string_view span) {
+        string name;
+        name.reserve(span.size());
+        bool gap = false;
+        for (char c : span) {
+            if (isSpace(c)) {
+                gap = true;
+                continue;
+            }
+            if (gap) name += '_';
+            gap = false;
+            name += c;
+        }
+        return name;
+    }
+
+    // Runs on the workers while the engine is only read
+    static void resolve(const LogicEngine& engine, Chunk& chunk) {
+        chunk.names.resize(chunk.atomCount());
+        chunk.global.resize(chunk.atomCount());
+        for (uint32_t a = 0; a < chunk.atomCount(); a++) {
+            chunk.names[a] = atomName(chunk.atomText(a));
+            chunk.global[a] = engine.atoms.find(chunk.names[a]);
+        }
+    }
+
+    // Single-threaded: new atoms are interned, postfix code becomes shared
+    // condition nodes
+    static void merge(LogicEngine& engine, Chunk& chunk, size_t firstLine, Report& report) {
+        vector<uint32_t>& global = chunk.global;
+        for (uint32_t a = 0; a < chunk.atomCount(); a++) {
+            if (global[a] == IdInterner::npos) global[a] = engine.atom(chunk.names[a]);
+        }
+
+        vector<uint32_t> stack;
+        for (const auto& entry : chunk.entries) {
+            if (entry.kind != KindRule) {
+                engine.giveFact(global[entry.atom], entry.kind == KindFact);
+                report.facts++;
+                continue;
+            }
+
+            stack.clear();
+            for (uint32_t i = entry.start; i < entry.start + entry.length; i++) {
+                uint32_t op = chunk.code[i] & ~operandMask;
+                if (op == CodeAtom) {
+                    stack.push_back(engine.atomLeaf(global[chunk.code[i] & operandMask]));
+                }
+                else if (op == CodeNot) {
+                    stack.back() = engine.node(LogicEngine::OpNot, stack.back());
+                }
+                else {
+                    uint32_t right = stack.back();
+                    stack.pop_back();
+                    stack.back() = engine.node(op == CodeAnd ? LogicEngine::OpAnd : LogicEngine::OpOr, stack.back(), right);
+                }
+            }
+            engine.addCompiledRule(stack.back(), global[entry.atom], "Loaded rule", "");
+            report.rules++;
+        }
+
+        for (const auto& e : chunk.errors) report.errors.push_back({ firstLine + e.line, e.message });
+    }
+
+public:
+    // Chunks of at least 64 KB each, split after a newline
+    static Report loadText(LogicEngine& engine, string_view text, unsigned threads = 0) {
+        const size_t minChunk = 1 << 16;
+        unsigned workers = workerCount(text.size(), minChunk, threads);
+
+        vector<size_t> bounds{ 0 };
+        for (unsigned w = 1; w < workers; w++) {
+            size_t at = max(bounds.back(), text.size() * w / workers);
+            at = text.find('\n', at);
+            at = at == string_view::npos ? text.size() : at + 1;
+            bounds.push_back(at);
+        }
+        bounds.push_back(text.size());
+
+        size_t count = bounds.size() - 1;
+        vector<Chunk> chunks(count);
+        parallelFor(count, (unsigned)count, [&](size_t begin, size_t end, unsigned) {
+            for (size_t c = begin; c < end; c++) {
+                parseChunk(chunks[c], text.substr(bounds[c], bounds[c + 1] - bounds[c]));
+                resolve(engine, chunks[c]);
+            }
+        });
+
+        // Upper bounds, so the tables grow once
+        size_t atoms = engine.atoms.size(), code = 0, entries = 0;
+        for (const auto& chunk : chunks) {
+            for (uint32_t g : chunk.global) atoms += g == IdInterner::npos;
+            code += chunk.code.size();
+            entries += chunk.entries.size();
+        }
+        engine.reserveAtoms(atoms);
+        engine.nodes.reserve(engine.nodes.size() + code + atoms);
+        engine.rules.reserve(engine.rules.size() + entries);
+
+        Report report;
+        for (auto& chunk : chunks) {
+            merge(engine, chunk, report.lines, report);
+            report.lines += chunk.lines;
+        }
+        return report;
+    }
+
+    // Throws runtime_error if the file cannot be opened
+    static Report loadFile(LogicEngine& engine, const string& path, unsigned threads = 0) {
+        MappedFile file(path);
+        return loadText(engine, file.view(), threads);
+    }
+};
+
+// Logic menu
+inline void LogicEngine::loadRuleFile(LogicEngine& engine) {
+    cout << endl;
+    cout << "Enter rule file path: ";
+    string path;
+    getline(cin, path);
+
+    try {
+        auto report = RuleFileLoader::loadFile(engine, path);
+        cout << "[SUCCESS] " << report.rules << " rule(s) and " << report.facts << " fact(s) loaded from "
+            << report.lines << " line(s)" << endl;
+        for (const auto& e : report.errors) cout << "  [ERROR] Line " << e.line << ": " << e.message << endl;
+    }
+    catch (const runtime_error& e) {
+        cout << "[ERROR] " << e.what() << endl;
+    }
+}
+
+#endif
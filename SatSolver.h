@@ -0,0 +1,556 @@
+#ifndef SATSOLVER_H
+#define SATSOLVER_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+using namespace std;
+
+// CDCL SAT Solver
+// Variables are 0, 1, 2, ...; literal 2v is v and 2v + 1 is NOT v.
+// Conflict-driven clause learning with two watched literals per clause,
+// first-UIP learning with recursive minimisation, VSIDS branching, phase
+// saving, Luby restarts and periodic removal of inactive learnt clauses.
+// solve() accepts assumption literals; when they cannot all hold,
+// failedAssumptions() is the subset actually used to refute them (an unsat
+// core).
+class SatSolver {
+public:
+    enum Result { Satisfiable, Unsatisfiable, Unknown };
+
+    static int lit(int var, bool negative = false) { return 2 * var + (negative ? 1 : 0); }
+    static int var(int lit) { return lit >> 1; }
+    static int negate(int lit) { return lit ^ 1; }
+
+private:
+    enum Value : uint8_t { True, False, Undef };
+
+    // Clauses live in one arena as [size, flags, activity, lits...] and are
+    // referred to by offset
+    enum Flags { Learnt = 1, Deleted = 2 };
+    static constexpr int header = 3;
+
+    struct Watcher {
+        uint32_t clause;
+        int blocker;
+    };
+
+    static constexpr uint32_t noReason = UINT32_MAX;
+
+    vector<int> arena;
+    size_t wasted = 0;
+    size_t problemClauses = 0;
+    vector<uint32_t> learnts;
+    vector<vector<Watcher>> watches;    // by literal: clauses to visit when it becomes false
+
+    vector<uint8_t> assigns;            // by variable
+    vector<int> level;
+    vector<uint32_t> reason;
+    vector<uint8_t> polarity;           // saved phase: 1 = negative
+    vector<int> trail;
+    vector<size_t> trailLimits;
+    size_t qhead = 0;
+
+    vector<double> activity;
+    vector<int> heap, heapIndex;        // max-heap on activity
+    double varIncrement = 1;
+    float clauseIncrement = 1;
+
+    vector<uint8_t> seen;
+    vector<int> toClear, stack;
+    vector<int> failed;
+    vector<uint8_t> model;
+    bool okay = true;
+
+    size_t conflictCount = 0, decisionCount = 0, propagationCount = 0;
+
+    int clauseSize(uint32_t c) const { return arena[c]; }
+    int* clauseLits(uint32_t c) { return &arena[c + header]; }
+    const int* clauseLits(uint32_t c) const { return &arena[c + header]; }
+    bool isDeleted(uint32_t c) const { return arena[c + 1] & Deleted; }
+
+    float clauseActivity(uint32_t c) const {
+        float a;
+        memcpy(&a, &arena[c + 2], sizeof a);
+        return a;
+    }
+
+    void setClauseActivity(uint32_t c, float a) { memcpy(&arena[c + 2], &a, sizeof a); }
+
+    Value value(int l) const {
+        uint8_t a = assigns[var(l)];
+        return a == Undef ? Undef : (Value)(a ^ (l & 1));
+    }
+
+    int decisionLevel() const { return (int)trailLimits.size(); }
+
+    // VSIDS heap
+    bool heapLess(int a, int b) const { return activity[a] > activity[b]; }
+
+    void heapUp(size_t i) {
+        int v = heap[i];
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (!heapLess(v, heap[parent])) break;
+            heap[i] = heap[parent];
+            heapIndex[heap[i]] = (int)i;
+            i = parent;
+        }
+        heap[i] = v;
+        heapIndex[v] = (int)i;
+    }
+
+    void heapDown(size_t i) {
+        int v = heap[i];
+        while (true) {
+            size_t child = 2 * i + 1;
+            if (child >= heap.size()) break;
+            if (child + 1 < heap.size() && heapLess(heap[child + 1], heap[child])) child++;
+            if (!heapLess(heap[child], v)) break;
+            heap[i] = heap[child];
+            heapIndex[heap[i]] = (int)i;
+            i = child;
+        }
+        heap[i] = v;
+        heapIndex[v] = (int)i;
+    }
+
+    void heapInsert(int v) {
+        if (heapIndex[v] >= 0) return;
+        heap.push_back(v);
+        heapUp(heap.size() - 1);
+    }
+
+    int heapPop() {
+        int top = heap[0];
+        heapIndex[top] = -1;
+        int last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            heapIndex[last] = 0;
+            heapDown(0);
+        }
+        return top;
+    }
+
+    void bumpVar(int v) {
+        if ((activity[v] += varIncrement) > 1e100) {
+            for (auto& a : activity) a *= 1e-100;
+            varIncrement *= 1e-100;
+        }
+        if (heapIndex[v] >= 0) heapUp(heapIndex[v]);
+    }
+
+    void bumpClause(uint32_t c) {
+        float a = clauseActivity(c) + clauseIncrement;
+        setClauseActivity(c, a);
+        if (a > 1e20f) {
+            for (uint32_t l : learnts) setClauseActivity(l, clauseActivity(l) * 1e-20f);
+            clauseIncrement *= 1e-20f;
+        }
+    }
+
+    void enqueue(int l, uint32_t from) {
+        int v = var(l);
+        assigns[v] = (uint8_t)(l & 1);
+        level[v] = decisionLevel();
+        reason[v] = from;
+        trail.push_back(l);
+    }
+
+    uint32_t allocate(const vector<int>& lits, bool learnt) {
+        uint32_t c = (uint32_t)arena.size();
+        arena.push_back((int)lits.size());
+        arena.push_back(learnt ? Learnt : 0);
+        arena.push_back(0);
+        arena.insert(arena.end(), lits.begin(), lits.end());
+        watches[negate(lits[0])].push_back({ c, lits[1] });
+        watches[negate(lits[1])].push_back({ c, lits[0] });
+        return c;
+    }
+
+    void cancelUntil(int target) {
+        if (decisionLevel() <= target) return;
+        for (size_t i = trail.size(); i-- > trailLimits[target];) {
+            int v = var(trail[i]);
+            assigns[v] = Undef;
+            polarity[v] = (uint8_t)(trail[i] & 1);
+            heapInsert(v);
+        }
+        trail.resize(trailLimits[target]);
+        trailLimits.resize(target);
+        qhead = trail.size();
+    }
+
+    // Returns the conflicting clause, or noReason
+    uint32_t propagate() {
+        while (qhead < trail.size()) {
+            int p = trail[qhead++];
+            int falseLit = negate(p);
+            vector<Watcher>& ws = watches[p];
+            propagationCount++;
+
+            Watcher* i = ws.data();
+            Watcher* j = ws.data();
+            Watcher* end = ws.data() + ws.size();
+            while (i != end) {
+                Watcher w = *i++;
+                if (value(w.blocker) == True) {
+                    *j++ = w;
+                    continue;
+                }
+                if (isDeleted(w.clause)) continue;
+
+                int* c = clauseLits(w.clause);
+                int size = clauseSize(w.clause);
+                if (c[0] == falseLit) swap(c[0], c[1]);
+                int first = c[0];
+                if (first != w.blocker && value(first) == True) {
+                    *j++ = { w.clause, first };
+                    continue;
+                }
+
+                bool moved = false;
+                for (int k = 2; k < size; k++) {
+                    if (value(c[k]) != False) {
+                        swap(c[1], c[k]);
+                        watches[negate(c[1])].push_back({ w.clause, first });
+                        moved = true;
+                        break;
+                    }
+                }
+                if (moved) continue;
+
+                *j++ = { w.clause, first };
+                if (value(first) == False) {
+                    while (i != end) *j++ = *i++;
+                    ws.resize(j - ws.data());
+                    qhead = trail.size();
+                    return w.clause;
+                }
+                enqueue(first, w.clause);
+            }
+            ws.resize(j - ws.data());
+        }
+        return noReason;
+    }
+
+    uint32_t abstractLevel(int v) const { return 1u << (level[v] & 31); }
+
+    // True if l is implied by literals already in the learnt clause; walks
+    // reasons transitively but only through levels present in the clause
+    bool redundant(int l, uint32_t levels) {
+        stack.assign(1, l);
+        size_t top = toClear.size();
+        while (!stack.empty()) {
+            uint32_t r = reason[var(stack.back())];
+            stack.pop_back();
+            const int* c = clauseLits(r);
+            for (int k = 1; k < clauseSize(r); k++) {
+                int q = c[k];
+                int v = var(q);
+                if (seen[v] || level[v] == 0) continue;
+                if (reason[v] != noReason && (abstractLevel(v) & levels)) {
+                    seen[v] = 1;
+                    stack.push_back(q);
+                    toClear.push_back(q);
+                    continue;
+                }
+                for (size_t t = top; t < toClear.size(); t++) seen[var(toClear[t])] = 0;
+                toClear.resize(top);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void analyze(uint32_t conflict, vector<int>& learnt, int& backLevel) {
+        learnt.assign(1, 0);
+        int pathCount = 0;
+        int p = -1;
+        size_t index = trail.size();
+
+        do {
+            if (arena[conflict + 1] & Learnt) bumpClause(conflict);
+            const int* c = clauseLits(conflict);
+            for (int k = (p == -1 ? 0 : 1); k < clauseSize(conflict); k++) {
+                int q = c[k];
+                int v = var(q);
+                if (seen[v] || level[v] == 0) continue;
+                seen[v] = 1;
+                bumpVar(v);
+                if (level[v] >= decisionLevel()) pathCount++;
+                else learnt.push_back(q);
+            }
+            while (!seen[var(trail[--index])]) {}
+            p = trail[index];
+            conflict = reason[var(p)];
+            seen[var(p)] = 0;
+            pathCount--;
+        } while (pathCount > 0);
+        learnt[0] = negate(p);
+
+        toClear.assign(learnt.begin() + 1, learnt.end());
+        uint32_t levels = 0;
+        for (size_t k = 1; k < learnt.size(); k++) levels |= abstractLevel(var(learnt[k]));
+        size_t keep = 1;
+        for (size_t k = 1; k < learnt.size(); k++) {
+            if (reason[var(learnt[k])] == noReason || !redundant(learnt[k], levels)) learnt[keep++] = learnt[k];
+        }
+        learnt.resize(keep);
+        for (int l : toClear) seen[var(l)] = 0;
+
+        backLevel = 0;
+        if (learnt.size() > 1) {
+            size_t best = 1;
+            for (size_t k = 2; k < learnt.size(); k++) {
+                if (level[var(learnt[k])] > level[var(learnt[best])]) best = k;
+            }
+            swap(learnt[1], learnt[best]);
+            backLevel = level[var(learnt[1])];
+        }
+    }
+
+    // Which assumptions forced the assumption a to be false
+    void analyzeFinal(int a) {
+        failed.assign(1, a);
+        if (decisionLevel() == 0) return;
+        seen[var(a)] = 1;
+        for (size_t i = trail.size(); i-- > trailLimits[0];) {
+            int v = var(trail[i]);
+            if (!seen[v]) continue;
+            if (reason[v] == noReason) {
+                failed.push_back(trail[i]);
+            }
+            else {
+                const int* c = clauseLits(reason[v]);
+                for (int k = 1; k < clauseSize(reason[v]); k++) {
+                    if (level[var(c[k])] > 0) seen[var(c[k])] = 1;
+                }
+            }
+            seen[v] = 0;
+        }
+        seen[var(a)] = 0;
+    }
+
+    bool locked(uint32_t c) const {
+        int first = clauseLits(c)[0];
+        return reason[var(first)] == c && value(first) == True;
+    }
+
+    void reduceLearnts() {
+        sort(learnts.begin(), learnts.end(), [&](uint32_t a, uint32_t b) {
+            return clauseActivity(a) < clauseActivity(b);
+        });
+        size_t half = learnts.size() / 2, keep = 0;
+        for (size_t i = 0; i < learnts.size(); i++) {
+            uint32_t c = learnts[i];
+            if (i < half && clauseSize(c) > 2 && !locked(c)) {
+                arena[c + 1] |= Deleted;
+                wasted += header + clauseSize(c);
+            }
+            else {
+                learnts[keep++] = learnts[i];
+            }
+        }
+        learnts.resize(keep);
+        if (wasted * 2 > arena.size()) collectGarbage();
+    }
+
+    // Copies live clauses into a fresh arena and remaps every reference
+    void collectGarbage() {
+        vector<int> fresh;
+        fresh.reserve(arena.size() - wasted);
+        vector<uint32_t> moved(arena.size(), noReason);
+        for (size_t c = 0; c < arena.size(); c += header + arena[c]) {
+            if (arena[c + 1] & Deleted) continue;
+            moved[c] = (uint32_t)fresh.size();
+            fresh.insert(fresh.end(), arena.begin() + c, arena.begin() + c + header + arena[c]);
+        }
+
+        for (auto& ws : watches) {
+            size_t keep = 0;
+            for (const Watcher& w : ws) {
+                if (moved[w.clause] != noReason) ws[keep++] = { moved[w.clause], w.blocker };
+            }
+            ws.resize(keep);
+        }
+        for (int l : trail) {
+            uint32_t& r = reason[var(l)];
+            if (r != noReason) r = moved[r];
+        }
+        for (auto& l : learnts) l = moved[l];
+        arena.swap(fresh);
+        wasted = 0;
+    }
+
+    static double luby(double y, int x) {
+        int size = 1, seq = 0;
+        while (size < x + 1) {
+            seq++;
+            size = 2 * size + 1;
+        }
+        while (size - 1 != x) {
+            size = (size - 1) >> 1;
+            seq--;
+            x = x % size;
+        }
+        double result = 1;
+        while (seq-- > 0) result *= y;
+        return result;
+    }
+
+    Result search(int conflictBudget, const vector<int>& assumptions, size_t& maxLearnts) {
+        vector<int> learnt;
+        int conflicts = 0;
+
+        while (true) {
+            uint32_t conflict = propagate();
+            if (conflict != noReason) {
+                conflictCount++;
+                conflicts++;
+                if (decisionLevel() == 0) return Unsatisfiable;
+
+                int backLevel;
+                analyze(conflict, learnt, backLevel);
+                cancelUntil(backLevel);
+                if (learnt.size() == 1) {
+                    enqueue(learnt[0], noReason);
+                }
+                else {
+                    uint32_t c = allocate(learnt, true);
+                    learnts.push_back(c);
+                    bumpClause(c);
+                    enqueue(learnt[0], c);
+                }
+                varIncrement /= 0.95;
+                clauseIncrement /= 0.999f;
+                continue;
+            }
+
+            if (conflicts >= conflictBudget) {
+                cancelUntil(0);
+                return Unknown;
+            }
+            if (learnts.size() >= maxLearnts + trail.size()) {
+                reduceLearnts();
+                maxLearnts = maxLearnts * 11 / 10;
+            }
+
+            int next = -1;
+            while (decisionLevel() < (int)assumptions.size()) {
+                int a = assumptions[decisionLevel()];
+                if (value(a) == True) {
+                    trailLimits.push_back(trail.size());
+                }
+                else if (value(a) == False) {
+                    analyzeFinal(a);
+                    return Unsatisfiable;
+                }
+                else {
+                    next = a;
+                    break;
+                }
+            }
+
+            if (next == -1) {
+                while (!heap.empty() && assigns[heap[0]] != Undef) heapPop();
+                if (heap.empty()) return Satisfiable;
+                int v = heapPop();
+                next = lit(v, polarity[v] != 0);
+            }
+            decisionCount++;
+            trailLimits.push_back(trail.size());
+            enqueue(next, noReason);
+        }
+    }
+
+public:
+    int newVar() {
+        int v = (int)assigns.size();
+        assigns.push_back(Undef);
+        level.push_back(0);
+        reason.push_back(noReason);
+        polarity.push_back(1);
+        activity.push_back(0);
+        seen.push_back(0);
+        heapIndex.push_back(-1);
+        watches.emplace_back();
+        watches.emplace_back();
+        heapInsert(v);
+        return v;
+    }
+
+    int varCount() const { return (int)assigns.size(); }
+    size_t clauseCount() const { return problemClauses; }
+
+    // Returns false once the clauses are already contradictory
+    bool addClause(vector<int> lits) {
+        if (!okay) return false;
+        cancelUntil(0);
+
+        sort(lits.begin(), lits.end());
+        size_t keep = 0;
+        for (size_t i = 0; i < lits.size(); i++) {
+            Value v = value(lits[i]);
+            if (v == True || (i > 0 && lits[i] == negate(lits[i - 1]))) return true;
+            if (v == False || (keep > 0 && lits[keep - 1] == lits[i])) continue;
+            lits[keep++] = lits[i];
+        }
+        lits.resize(keep);
+        problemClauses++;
+
+        if (lits.empty()) return okay = false;
+        if (lits.size() == 1) {
+            enqueue(lits[0], noReason);
+            return okay = propagate() == noReason;
+        }
+        allocate(lits, false);
+        return true;
+    }
+
+    // conflictLimit < 0 means no limit
+    Result solve(const vector<int>& assumptions = {}, long long conflictLimit = -1) {
+        failed.clear();
+        if (!okay) return Unsatisfiable;
+
+        size_t maxLearnts = max<size_t>(problemClauses / 3, 2000);
+        long long spent = 0;
+        Result result = Unknown;
+        for (int restart = 0; result == Unknown; restart++) {
+            int budget = (int)(luby(2, restart) * 100);
+            if (conflictLimit >= 0) {
+                if (spent >= conflictLimit) break;
+                budget = (int)min<long long>(budget, conflictLimit - spent);
+            }
+            size_t before = conflictCount;
+            result = search(budget, assumptions, maxLearnts);
+            spent += (long long)(conflictCount - before);
+        }
+
+        if (result == Satisfiable) {
+            model.assign(assigns.size(), 0);
+            for (size_t v = 0; v < assigns.size(); v++) model[v] = assigns[v] == True;
+        }
+        else if (result == Unsatisfiable && failed.empty()) {
+            okay = false;       // refuted without using any assumption
+        }
+        cancelUntil(0);
+        return result;
+    }
+
+    // Value of v in the model found by the last Satisfiable answer
+    bool modelValue(int v) const { return model[v] != 0; }
+
+    // Assumption literals behind the last Unsatisfiable answer;
+    // empty if the clauses are contradictory on their own
+    const vector<int>& failedAssumptions() const { return failed; }
+
+    size_t conflicts() const { return conflictCount; }
+    size_t decisions() const { return decisionCount; }
+    size_t propagations() const { return propagationCount; }
+};
+
+#endif
@@ -9,7 +9,13 @@
 #include <algorithm>
 #include <iostream>
 #include <limits>
+#include <random>
+#include <memory>
 #include "BaseClasses.h"
+#include "Trace.h"
+#include "PrerequisiteGraph.h"
+#include "LinearExtensions.h"
+#include "Eligibility.h"
 using namespace std;
 
 // Course & Scheduling Module
@@ -18,9 +24,15 @@ private:
     map<string, set<string>> prerequisites;
     map<string, set<string>> adjacencyList;
     set<string> allCourses;
+    unique_ptr<EligibilityTracker> eligibility;     // built on first use, dropped when the catalog changes
+    TraceSink* trace = &consoleTrace();
 
 public:
+    // Narration for validateEnrollment / getValidSequence
+    void setTraceSink(TraceSink& sink) { trace = &sink; }
+
     void addCourse(const string& courseId) {
+        eligibility.reset();
         allCourses.insert(courseId);
         if (prerequisites.find(courseId) == prerequisites.end()) {
             prerequisites[courseId] = set<string>();
@@ -28,12 +40,17 @@ public:
     }
 
     void addPrerequisite(const string& course, const string& prereq) {
+        eligibility.reset();
         prerequisites[course].insert(prereq);
         adjacencyList[prereq].insert(course);
         allCourses.insert(course);
         allCourses.insert(prereq);
     }
 
+    PrerequisiteGraph buildGraph() const {
+        return PrerequisiteGraph::build(prerequisites, allCourses);
+    }
+
     vector<string> getValidSequence() {
         map<string, int> inDegree;
         for (const auto& course : allCourses) {
@@ -62,7 +79,10 @@ public:
         }
 
         if (result.size() != allCourses.size()) {
-            cout << "[ERROR] Circular dependency detected!"<<endl;
+            if (trace->wants(TraceLevel::Summary)) {
+                trace->stream() << "[ERROR] Circular dependency detected!" << "\n";
+                trace->flush();
+            }
             return {};
         }
 
@@ -89,6 +109,16 @@ public:
         return available;
     }
 
+    // Same answer from this scheduler's eligibility tracker, brought up to
+    // date from the student's record; the catalog is not rescanned
+    vector<string> getAvailableCourses(const Student& student) {
+        if (!eligibility) eligibility.reset(new EligibilityTracker(buildGraph()));
+        eligibility->syncStudent(student);
+        vector<string> available = eligibility->nextCourses(student.getId());
+        sort(available.begin(), available.end());
+        return available;
+    }
+
     //  Check Missing Prerequisites
     vector<string> getMissingPrerequisites(const string& course,
         const set<string>& completedCourses) {
@@ -104,14 +134,19 @@ public:
     //  Validate Enrollment 
     bool validateEnrollment(Student& student, const string& courseId,
         const vector<Course>& allCoursesData) {
-        cout << endl;
-        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
-        cout << "     ENROLLMENT VALIDATION"<<endl;
-        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
-        cout << endl;
-        cout << endl;
-        cout << "[INFO] Student: " << student.getName() << " (" << student.getId() << ")"<<endl;
-        cout << "[INFO] Requesting: " << courseId << endl;
+        bool proof = trace->wants(TraceLevel::Proof);
+        bool summary = trace->wants(TraceLevel::Summary);
+        ostream& out = trace->stream();
+
+        if (proof) {
+            out << "\n";
+            out << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << "\n";
+            out << "     ENROLLMENT VALIDATION" << "\n";
+            out << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << "\n";
+            out << "\n\n";
+            out << "[INFO] Student: " << student.getName() << " (" << student.getId() << ")" << "\n";
+            out << "[INFO] Requesting: " << courseId << "\n";
+        }
 
         // Get student completed courses
         set<string> completed = student.getCourses();
@@ -120,29 +155,36 @@ public:
         auto missing = getMissingPrerequisites(courseId, completed);
 
         if (missing.empty()) {
-            cout << endl;
-            cout << "[SUCCESS] All prerequisites satisfied!"<<endl;
-            cout << "[SUCCESS] Student can enroll in " << courseId << endl;
+            if (summary) {
+                out << "\n";
+                if (proof) out << "[SUCCESS] All prerequisites satisfied!" << "\n";
+                out << "[SUCCESS] Student can enroll in " << courseId << "\n";
+            }
+            trace->flush();
             return true;
         }
-        else {
-            cout << endl;
-            cout << "[ERROR] Cannot enroll! Missing prerequisites:"<<endl;
+
+        if (summary) {
+            out << "\n";
+            out << "[ERROR] Cannot enroll! Missing prerequisites:" << "\n";
             for (const auto& m : missing) {
-                cout << "  - " << m;
+                out << "  - " << m;
                 // Find course name
                 for (const auto& c : allCoursesData) {
                     if (c.getId() == m) {
-                        cout << " (" << c.getName() << ")";
+                        out << " (" << c.getName() << ")";
                         break;
                     }
                 }
-                cout << endl;
+                out << "\n";
+            }
+            if (proof) {
+                out << "\n";
+                out << "[INFO] Student must complete these courses first!" << "\n";
             }
-            cout << endl;
-            cout << "[INFO] Student must complete these courses first!"<<endl;
-            return false;
         }
+        trace->flush();
+        return false;
     }
 
     // INTERACTIVE: View Course Prerequisites
@@ -272,6 +314,7 @@ public:
             cin >> confirm;
             if (confirm == 'y' || confirm == 'Y') {
                 student.enrollCourse(course.getId());
+                EnrollmentEvents::enrolled(student.getId(), course.getId());
                 cout << "[SUCCESS] Enrolled!"<<endl;
             }
         }
@@ -331,7 +374,7 @@ public:
             }
         }
 
-        auto available = scheduler.getAvailableCourses(completed);
+        auto available = scheduler.getAvailableCourses(student);
         cout << endl;
         cout << "[SUCCESS] Available Courses:"<<endl;
         if (available.empty()) {
@@ -489,6 +532,15 @@ public:
         for (const auto& course : available) {
             cout << "  - " << course << endl;
         }
+
+        // Curriculum flexibility
+        LinearExtensions orderings(scheduler.buildGraph());
+        cout << endl;
+        cout << "[INFO] Number of valid course orderings: " << orderings.count().toString() << endl;
+        mt19937 rng(random_device{}());
+        cout << "[INFO] Random valid ordering: ";
+        for (const auto& c : orderings.sampleNames(rng)) cout << c << " ";
+        cout << endl;
         cout << endl;
         cout << "[SUCCESS] Module 1 Complete!"<<endl;
     }
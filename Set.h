@@ -7,62 +7,145 @@
 #include <iostream>
 #include <limits>
 #include "BaseClasses.h"
+#include "FlatSet.h"
+#include "SetExpr.h"
+#include "RoaringBitmap.h"
+#include "Interner.h"
+#include "Subsets.h"
+#include "CartesianProduct.h"
+#include "SimilarityJoin.h"
+#include "CardinalitySketch.h"
 using namespace std;
 
 // Set Operations
+// The work is done on FlatSet (sorted vectors); the std::set overloads
+// convert their arguments and the result. Sets of interned ids can also be
+// RoaringBitmaps (compressed bitmaps).
 template <typename T>
 class SetOperations {
 public:
+    static FlatSet<T> setUnion(const FlatSet<T>& A, const FlatSet<T>& B) {
+        return FlatSet<T>::unionOf(A, B);
+    }
+
+    static FlatSet<T> setIntersection(const FlatSet<T>& A, const FlatSet<T>& B) {
+        return FlatSet<T>::intersectionOf(A, B);
+    }
+
+    static FlatSet<T> setDifference(const FlatSet<T>& A, const FlatSet<T>& B) {
+        return FlatSet<T>::differenceOf(A, B);
+    }
+
+    static bool isSubset(const FlatSet<T>& A, const FlatSet<T>& B) {
+        return FlatSet<T>::isSubset(A, B);
+    }
+
+    // Merge-path slices on every core, for archive-sized sets
+    static FlatSet<T> parallelUnion(const FlatSet<T>& A, const FlatSet<T>& B, unsigned threads = 0) {
+        return FlatSet<T>::parallelUnionOf(A, B, threads);
+    }
+
+    static FlatSet<T> parallelIntersection(const FlatSet<T>& A, const FlatSet<T>& B, unsigned threads = 0) {
+        return FlatSet<T>::parallelIntersectionOf(A, B, threads);
+    }
+
+    static FlatSet<T> parallelDifference(const FlatSet<T>& A, const FlatSet<T>& B, unsigned threads = 0) {
+        return FlatSet<T>::parallelDifferenceOf(A, B, threads);
+    }
+
+    // k-way: one pass over all inputs, smallest set first for intersection
+    static FlatSet<T> setIntersection(const vector<const FlatSet<T>*>& sets) {
+        return FlatSet<T>::intersectionOfAll(sets);
+    }
+
+    static FlatSet<T> setUnion(const vector<const FlatSet<T>*>& sets) {
+        return FlatSet<T>::unionOfAll(sets);
+    }
+
     static set<T> setUnion(const set<T>& A, const set<T>& B) {
-        set<T> result = A;
-        result.insert(B.begin(), B.end());
-        return result;
+        return setUnion(FlatSet<T>(A), FlatSet<T>(B)).toSet();
     }
 
     static set<T> setIntersection(const set<T>& A, const set<T>& B) {
-        set<T> result;
-        set_intersection(A.begin(), A.end(), B.begin(), B.end(),
-            inserter(result, result.begin()));
-        return result;
+        return setIntersection(FlatSet<T>(A), FlatSet<T>(B)).toSet();
     }
 
     static set<T> setDifference(const set<T>& A, const set<T>& B) {
-        set<T> result;
-        set_difference(A.begin(), A.end(), B.begin(), B.end(),
-            inserter(result, result.begin()));
-        return result;
+        return setDifference(FlatSet<T>(A), FlatSet<T>(B)).toSet();
     }
 
     static bool isSubset(const set<T>& A, const set<T>& B) {
-        return includes(B.begin(), B.end(), A.begin(), A.end());
+        return isSubset(FlatSet<T>(A), FlatSet<T>(B));
     }
 
-    static vector<set<T>> powerSet(const set<T>& S) {
-        vector<T> elements(S.begin(), S.end());
-        int n = elements.size();
-        int powerSetSize = 1 << n;
+    static FlatSet<T> setSymmetricDifference(const FlatSet<T>& A, const FlatSet<T>& B) {
+        return (A ^ B).toFlatSet();
+    }
 
-        vector<set<T>> result;
-        for (int i = 0; i < powerSetSize; i++) {
-            set<T> subset;
-            for (int j = 0; j < n; j++) {
-                if (i & (1 << j)) {
-                    subset.insert(elements[j]);
-                }
-            }
-            result.push_back(subset);
+    static set<T> setSymmetricDifference(const set<T>& A, const set<T>& B) {
+        return setSymmetricDifference(FlatSet<T>(A), FlatSet<T>(B)).toSet();
+    }
+
+    // Set expressions (A | B, A & B, A - B, A ^ B) in one fused pass
+    template <typename E>
+    static FlatSet<T> evaluate(const SetExpr<E, T>& expr) {
+        return expr.toFlatSet();
+    }
+
+    template <typename E>
+    static size_t cardinality(const SetExpr<E, T>& expr) { return expr.size(); }
+
+    static RoaringBitmap setUnion(const RoaringBitmap& A, const RoaringBitmap& B) {
+        return RoaringBitmap::unionOf(A, B);
+    }
+
+    static RoaringBitmap setIntersection(const RoaringBitmap& A, const RoaringBitmap& B) {
+        return RoaringBitmap::intersectionOf(A, B);
+    }
+
+    static RoaringBitmap setDifference(const RoaringBitmap& A, const RoaringBitmap& B) {
+        return RoaringBitmap::differenceOf(A, B);
+    }
+
+    static bool isSubset(const RoaringBitmap& A, const RoaringBitmap& B) {
+        return RoaringBitmap::isSubset(A, B);
+    }
+
+    static size_t cardinality(const RoaringBitmap& A) { return A.size(); }
+
+    // |A n B| without building the intersection
+    static size_t intersectionCardinality(const RoaringBitmap& A, const RoaringBitmap& B) {
+        return RoaringBitmap::intersectionSize(A, B);
+    }
+
+    // Lazy subsets (by size, filterable, splittable across threads)
+    static Subsets<T> subsets(const set<T>& S) {
+        return Subsets<T>(S);
+    }
+
+    // Materializes every subset, smallest first; use subsets() for large sets
+    static vector<set<T>> powerSet(const set<T>& S) {
+        if (S.size() > 20) {
+            throw runtime_error("Power set of " + to_string(S.size()) + " elements is too large to materialize; use subsets()");
         }
+        Subsets<T> all(S);
+        vector<set<T>> result;
+        result.reserve((size_t)all.count());
+        all.forEach([&](const SubsetView<T>& subset) {
+            result.push_back(subset.toSet());
+            return true;
+        });
         return result;
     }
 
+    // Lazy A x B: indexable and splittable, nothing materialized
+    static CartesianProduct<T, T> product(const set<T>& A, const set<T>& B) {
+        return CartesianProduct<T, T>(A, B);
+    }
+
+    // Pairs come out in sorted order, so each insert is at the end hint
     static set<pair<T, T>> cartesianProduct(const set<T>& A, const set<T>& B) {
-        set<pair<T, T>> result;
-        for (const auto& a : A) {
-            for (const auto& b : B) {
-                result.insert({ a, b });
-            }
-        }
-        return result;
+        return product(A, B).toSet();
     }
 
     static void displaySet(const set<T>& S, const string& name = "Set") {
@@ -71,6 +154,12 @@ public:
         cout << "}"<<endl;
     }
 
+    static void displaySet(const FlatSet<T>& S, const string& name = "Set") {
+        cout << name << ": { ";
+        for (const auto& e : S) cout << e << " ";
+        cout << "}"<<endl;
+    }
+
     // View Students as Set
     static void viewStudentsAsSet(const vector<Student>& students) {
         cout << endl;
@@ -106,8 +195,9 @@ public:
         }
         else {
             cout << endl;
-            cout << "[INFO] Power set too large to display (2^"
-                << studentSet.size() << " = " << (1 << studentSet.size()) << " subsets)"<<endl;
+            cout << "[INFO] Power set too large to display (2^" << studentSet.size();
+            if (studentSet.size() < 64) cout << " = " << (1ULL << studentSet.size());
+            cout << " subsets)"<<endl;
         }
     }
 
@@ -159,16 +249,17 @@ public:
         string course2 = courseVec[c2 - 1];
 
         // Build sets
-        set<string> studentsInCourse1, studentsInCourse2;
+        vector<string> roster1, roster2;
 
         for (const auto& s : students) {
             if (s.isEnrolledIn(course1)) {
-                studentsInCourse1.insert(s.getId());
+                roster1.push_back(s.getId());
             }
             if (s.isEnrolledIn(course2)) {
-                studentsInCourse2.insert(s.getId());
+                roster2.push_back(s.getId());
             }
         }
+        FlatSet<string> studentsInCourse1(move(roster1)), studentsInCourse2(move(roster2));
         cout << endl;
         cout << "[SUCCESS] Results:"<<endl;
         displaySet(studentsInCourse1, "Students in " + course1);
@@ -182,6 +273,154 @@ public:
 
         auto diff = setDifference(studentsInCourse1, studentsInCourse2);
         displaySet(diff, "Difference (Only " + course1 + ")");
+
+        displaySet(setSymmetricDifference(studentsInCourse1, studentsInCourse2), "Symmetric Difference (Exactly one course)");
+    }
+
+    // Find Students in All / Any of Several Courses
+    static void findStudentsInAllCourses(const vector<Student>& students) {
+        cout << endl;
+        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
+        cout << "     STUDENTS IN ALL / ANY OF SEVERAL COURSES"<<endl;
+        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
+        cout << endl;
+
+        set<string> allCourses;
+        for (const auto& s : students) {
+            auto courses = s.getCourses();
+            allCourses.insert(courses.begin(), courses.end());
+        }
+        if (allCourses.empty()) {
+            cout << "[ERROR] No enrollments available!"<<endl;
+            return;
+        }
+
+        cout << "[INFO] Available Courses:" << endl;
+        vector<string> courseVec(allCourses.begin(), allCourses.end());
+        for (size_t i = 0; i < courseVec.size(); i++) {
+            cout << "  " << (i + 1) << ". " << courseVec[i] << endl;
+        }
+        cout << endl;
+        cout << "Enter course numbers (0 to finish): ";
+
+        vector<string> chosen;
+        int pick;
+        while (cin >> pick && pick != 0) {
+            if (pick < 1 || pick > (int)courseVec.size()) {
+                cout << "[ERROR] Invalid selection: " << pick << endl;
+                continue;
+            }
+            chosen.push_back(courseVec[pick - 1]);
+        }
+        if (chosen.empty()) {
+            cout << "[ERROR] No courses selected!"<<endl;
+            return;
+        }
+
+        // One roster per course, then a single k-way pass each
+        vector<FlatSet<string>> rosters;
+        for (const auto& course : chosen) {
+            vector<string> roster;
+            for (const auto& s : students) {
+                if (s.isEnrolledIn(course)) roster.push_back(s.getId());
+            }
+            rosters.emplace_back(move(roster));
+        }
+        vector<const FlatSet<string>*> inputs;
+        for (const auto& r : rosters) inputs.push_back(&r);
+
+        cout << endl;
+        cout << "[SUCCESS] Results:"<<endl;
+        for (size_t i = 0; i < chosen.size(); i++) displaySet(rosters[i], "Students in " + chosen[i]);
+        displaySet(SetOperations<string>::setIntersection(inputs), "In all selected courses");
+        displaySet(SetOperations<string>::setUnion(inputs), "In any selected course");
+    }
+
+    // Students with Similar Course Sets (Jaccard similarity join)
+    static void findSimilarStudents(const vector<Student>& students) {
+        cout << endl;
+        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
+        cout << "     STUDENTS WITH SIMILAR COURSE SETS"<<endl;
+        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
+        cout << endl;
+
+        cout << "Minimum Jaccard similarity (0 < t <= 1): ";
+        double t;
+        if (!(cin >> t) || t <= 0 || t > 1) {
+            cout << "[ERROR] Invalid threshold!"<<endl;
+            return;
+        }
+
+        vector<vector<string>> courseSets;
+        for (const auto& s : students) {
+            auto courses = s.getCourses();
+            courseSets.emplace_back(courses.begin(), courses.end());
+        }
+        auto matches = SimilarityJoin::selfJoin(courseSets, t);
+
+        cout << endl;
+        if (matches.empty()) {
+            cout << "[INFO] No pairs of students reach " << t << endl;
+            return;
+        }
+        cout << "[SUCCESS] " << matches.size() << " pair(s):"<<endl;
+        for (const auto& m : matches) {
+            cout << "  " << students[m.first].getId() << " ~ " << students[m.second].getId()
+                << "  (J = " << m.similarity << ")" << endl;
+        }
+    }
+
+    // Approximate Enrollment Counts (HyperLogLog sketch per course)
+    static void estimateEnrollments(const vector<Student>& students) {
+        cout << endl;
+        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
+        cout << "     APPROXIMATE ENROLLMENT COUNTS"<<endl;
+        cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << endl;
+        cout << endl;
+
+        const EnrollmentSketches& sketches = campusEnrollmentSketches(students);
+        if (sketches.courseCount() == 0) {
+            cout << "[ERROR] No enrollments available!"<<endl;
+            return;
+        }
+
+        set<string> allCourses;
+        for (const auto& s : students) {
+            auto courses = s.getCourses();
+            allCourses.insert(courses.begin(), courses.end());
+        }
+        vector<string> courseVec(allCourses.begin(), allCourses.end());
+        cout << "[INFO] Courses (estimated students):" << endl;
+        for (size_t i = 0; i < courseVec.size(); i++) {
+            cout << "  " << (i + 1) << ". " << courseVec[i] << " (~" << llround(sketches.students(courseVec[i])) << ")" << endl;
+        }
+        cout << endl;
+        cout << "Enter course numbers (0 to finish): ";
+
+        vector<string> chosen;
+        int pick;
+        while (cin >> pick && pick != 0) {
+            if (pick < 1 || pick > (int)courseVec.size()) {
+                cout << "[ERROR] Invalid selection: " << pick << endl;
+                continue;
+            }
+            chosen.push_back(courseVec[pick - 1]);
+        }
+        if (chosen.empty()) {
+            cout << "[ERROR] No courses selected!"<<endl;
+            return;
+        }
+
+        cout << endl;
+        cout << "[SUCCESS] Estimates:"<<endl;
+        cout << "  Distinct students in any selected course: ~" << llround(sketches.distinctStudents(chosen)) << endl;
+        if (chosen.size() <= EnrollmentSketches::maxAllCourses) {
+            cout << "  Students in all selected courses: ~" << llround(sketches.studentsInAll(chosen)) << endl;
+        }
+        else {
+            cout << "  Students in all selected courses: not estimated for more than "
+                << EnrollmentSketches::maxAllCourses << " courses (the error grows with each one)" << endl;
+        }
     }
 
     // INTERACTIVE: Set Operations on Entities
@@ -198,7 +437,8 @@ public:
         cout << "  2. Courses Set"<<endl;
         cout << "  3. Faculty Set"<<endl;
         cout << "  4. Rooms Set"<<endl;
-        cout << "  5. Cartesian Product (Students * Courses)"<<endl<<endl;
+        cout << "  5. Cartesian Product (Students * Courses)"<<endl;
+        cout << "  6. Course Rosters (Compressed Bitmaps)"<<endl<<endl;
         cout << "  Choice: ";
 
         int choice;
@@ -238,29 +478,47 @@ public:
             for (const auto& s : students) S.insert(s.getId());
             for (const auto& c : courses) C.insert(c.getId());
 
-            auto cartesian = cartesianProduct(S, C);
+            auto cartesian = product(S, C);
             cout << endl;
             cout << "[SUCCESS] Cartesian Product S * C:"<<endl;
             cout << "Size: |S * C| = " << cartesian.size()
                 << " (= " << S.size() << " *" << C.size() << ")"<<endl<<endl;
 
-            if (cartesian.size() <= 20) {
-                cout << "Pairs:"<<endl;
-                for (const auto& p : cartesian) {
-                    cout << "  (" << p.first << ", " << p.second << ")"<<endl;
-                }
+            bool all = cartesian.size() <= 20;
+            uint64_t shown = all ? cartesian.size() : 10;
+            cout << (all ? "Pairs:" : "First 10 pairs:")<<endl;
+            for (uint64_t i = 0; i < shown; i++) {
+                auto p = cartesian.at(i);
+                cout << "  (" << p.first << ", " << p.second << ")"<<endl;
             }
-            else {
-                cout << "First 10 pairs:"<<endl;
-                int count = 0;
-                for (const auto& p : cartesian) {
-                    cout << "  (" << p.first << ", " << p.second << ")"<<endl;
-                    if (++count >= 10) break;
-                }
+            if (!all) {
                 cout << "  ... and " << (cartesian.size() - 10) << " more"<<endl;
             }
             break;
         }
+        case 6: {
+            // Students as interned ids, one bitmap per course
+            IdInterner ids;
+            RoaringBitmap everyone;
+            for (const auto& s : students) everyone.add(ids.intern(s.getId()));
+
+            RoaringBitmap enrolled;
+            cout << endl;
+            for (const auto& c : courses) {
+                RoaringBitmap roster;
+                for (const auto& s : students) {
+                    if (s.isEnrolledIn(c.getId())) roster.add(ids.find(s.getId()));
+                }
+                roster.runOptimize();
+                cout << "  " << c.getId() << ": " << cardinality(roster) << " students, "
+                    << roster.sizeInBytes() << " bytes" << endl;
+                enrolled = setUnion(enrolled, roster);
+            }
+            cout << endl;
+            cout << "Enrolled in a listed course: " << cardinality(enrolled) << endl;
+            cout << "Not enrolled in any: " << cardinality(setDifference(everyone, enrolled)) << endl;
+            break;
+        }
         default:
             cout << "[ERROR] Invalid choice!"<<endl;
         }
@@ -281,6 +539,9 @@ public:
             cout << "  2. Find Students in Multiple Courses (Intersection)"<<endl;
             cout << "  3. Set Operations on All Entities"<<endl;
             cout << "  4. Run Demonstration (Hard-coded Examples)"<<endl;
+            cout << "  5. Find Students in All / Any of Several Courses"<<endl;
+            cout << "  6. Find Students with Similar Course Sets"<<endl;
+            cout << "  7. Approximate Enrollment Counts (Sketches)"<<endl;
             cout << "  0. Back to Main Menu"<<endl;
             cout << "  Choice: ";
 
@@ -306,6 +567,15 @@ public:
             case 4:
                 demonstrate();
                 break;
+            case 5:
+                findStudentsInAllCourses(students);
+                break;
+            case 6:
+                findSimilarStudents(students);
+                break;
+            case 7:
+                estimateEnrollments(students);
+                break;
             default:
                 cout << "[ERROR] Invalid choice!"<<endl;
             }
@@ -0,0 +1,299 @@
+#ifndef SET_EXPR_H
+#define SET_EXPR_H
+
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include "FlatSet.h"
+using namespace std;
+
+// Set Expressions
+// A | B (union), A & B (intersection), A - B (difference) and A ^ B
+// (symmetric difference) over FlatSets build an expression instead of a
+// set. Evaluating it runs one cursor per node over the sorted inputs:
+// every cursor yields its elements in order, and seek(x) skips to the first
+// element not below x (galloping at the leaves), so an intersection jumps
+// over the parts of its inputs that cannot match. No temporaries are built;
+// size() counts the stream without allocating anything.
+//
+// Operands are referenced, not copied: they must outlive the expression.
+// C++ binds - before &, & before ^, and ^ before |, so use parentheses.
+struct SetExprTag {};
+
+template <typename E, typename T>
+struct SetExpr : SetExprTag {
+    const E& self() const { return static_cast<const E&>(*this); }
+
+    // Visits the elements in order; fn returns false to stop
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (auto c = self().cursor(); !c.done(); c.next()) {
+            if (!fn(c.value())) return;
+        }
+    }
+
+    size_t size() const {
+        size_t n = 0;
+        for (auto c = self().cursor(); !c.done(); c.next()) n++;
+        return n;
+    }
+
+    bool empty() const { return self().cursor().done(); }
+
+    bool contains(const T& x) const {
+        auto c = self().cursor();
+        c.seek(x);
+        return !c.done() && !(x < c.value());
+    }
+
+    // Appends the elements to out
+    void into(vector<T>& out) const {
+        for (auto c = self().cursor(); !c.done(); c.next()) out.push_back(c.value());
+    }
+
+    FlatSet<T> toFlatSet() const {
+        vector<T> out;
+        into(out);
+        return FlatSet<T>::fromSorted(move(out));
+    }
+};
+
+// Leaf: a FlatSet
+template <typename T>
+class SetRef : public SetExpr<SetRef<T>, T> {
+private:
+    const FlatSet<T>* set;
+
+public:
+    using value_type = T;
+
+    struct Cursor {
+        const T* at;
+        const T* end;
+
+        bool done() const { return at == end; }
+        const T& value() const { return *at; }
+        void next() { ++at; }
+
+        // Doubling steps, then a binary search of the last gap
+        void seek(const T& x) {
+            size_t step = 1;
+            const T* lo = at;
+            while (lo + step < end && lo[step] < x) {
+                lo += step;
+                step *= 2;
+            }
+            at = lower_bound(lo, min(lo + step + 1, end), x);
+        }
+    };
+
+    explicit SetRef(const FlatSet<T>& s) : set(&s) {}
+    Cursor cursor() const { return { set->data(), set->data() + set->size() }; }
+};
+
+template <typename L, typename R>
+class UnionExpr : public SetExpr<UnionExpr<L, R>, typename L::value_type> {
+private:
+    L left;
+    R right;
+
+public:
+    using value_type = typename L::value_type;
+
+    struct Cursor {
+        typename L::Cursor l;
+        typename R::Cursor r;
+
+        bool done() const { return l.done() && r.done(); }
+        const value_type& value() const {
+            if (l.done()) return r.value();
+            if (r.done() || l.value() < r.value()) return l.value();
+            return r.value();
+        }
+        void next() {
+            if (l.done()) r.next();
+            else if (r.done() || l.value() < r.value()) l.next();
+            else if (r.value() < l.value()) r.next();
+            else {
+                l.next();
+                r.next();
+            }
+        }
+        void seek(const value_type& x) {
+            l.seek(x);
+            r.seek(x);
+        }
+    };
+
+    UnionExpr(L a, R b) : left(a), right(b) {}
+    Cursor cursor() const { return { left.cursor(), right.cursor() }; }
+};
+
+template <typename L, typename R>
+class IntersectionExpr : public SetExpr<IntersectionExpr<L, R>, typename L::value_type> {
+private:
+    L left;
+    R right;
+
+public:
+    using value_type = typename L::value_type;
+
+    // Always parked on a common element (or done)
+    struct Cursor {
+        typename L::Cursor l;
+        typename R::Cursor r;
+
+        void settle() {
+            while (!l.done() && !r.done()) {
+                if (l.value() < r.value()) l.seek(r.value());
+                else if (r.value() < l.value()) r.seek(l.value());
+                else return;
+            }
+        }
+        bool done() const { return l.done() || r.done(); }
+        const value_type& value() const { return l.value(); }
+        void next() {
+            l.next();
+            r.next();
+            settle();
+        }
+        void seek(const value_type& x) {
+            l.seek(x);
+            r.seek(x);
+            settle();
+        }
+    };
+
+    IntersectionExpr(L a, R b) : left(a), right(b) {}
+    Cursor cursor() const {
+        Cursor c{ left.cursor(), right.cursor() };
+        c.settle();
+        return c;
+    }
+};
+
+template <typename L, typename R>
+class DifferenceExpr : public SetExpr<DifferenceExpr<L, R>, typename L::value_type> {
+private:
+    L left;
+    R right;
+
+public:
+    using value_type = typename L::value_type;
+
+    // Always parked on a left element the right side lacks (or done)
+    struct Cursor {
+        typename L::Cursor l;
+        typename R::Cursor r;
+
+        void settle() {
+            while (!l.done()) {
+                r.seek(l.value());
+                if (r.done() || l.value() < r.value()) return;
+                l.next();
+            }
+        }
+        bool done() const { return l.done(); }
+        const value_type& value() const { return l.value(); }
+        void next() {
+            l.next();
+            settle();
+        }
+        void seek(const value_type& x) {
+            l.seek(x);
+            settle();
+        }
+    };
+
+    DifferenceExpr(L a, R b) : left(a), right(b) {}
+    Cursor cursor() const {
+        Cursor c{ left.cursor(), right.cursor() };
+        c.settle();
+        return c;
+    }
+};
+
+template <typename L, typename R>
+class SymmetricDifferenceExpr : public SetExpr<SymmetricDifferenceExpr<L, R>, typename L::value_type> {
+private:
+    L left;
+    R right;
+
+public:
+    using value_type = typename L::value_type;
+
+    // Never parked on an element both sides have
+    struct Cursor {
+        typename L::Cursor l;
+        typename R::Cursor r;
+
+        void settle() {
+            while (!l.done() && !r.done() && !(l.value() < r.value()) && !(r.value() < l.value())) {
+                l.next();
+                r.next();
+            }
+        }
+        bool done() const { return l.done() && r.done(); }
+        const value_type& value() const {
+            if (l.done()) return r.value();
+            if (r.done() || l.value() < r.value()) return l.value();
+            return r.value();
+        }
+        void next() {
+            if (l.done()) r.next();
+            else if (r.done() || l.value() < r.value()) l.next();
+            else r.next();
+            settle();
+        }
+        void seek(const value_type& x) {
+            l.seek(x);
+            r.seek(x);
+            settle();
+        }
+    };
+
+    SymmetricDifferenceExpr(L a, R b) : left(a), right(b) {}
+    Cursor cursor() const {
+        Cursor c{ left.cursor(), right.cursor() };
+        c.settle();
+        return c;
+    }
+};
+
+// FlatSets become leaves; expressions are used as they are
+template <typename T>
+SetRef<T> asSetExpr(const FlatSet<T>& s) { return SetRef<T>(s); }
+
+template <typename E, typename T>
+const E& asSetExpr(const SetExpr<E, T>& e) { return e.self(); }
+
+template <typename X>
+struct IsSetOperand : is_base_of<SetExprTag, X> {};
+
+template <typename T>
+struct IsSetOperand<FlatSet<T>> : true_type {};
+
+template <typename X>
+using SetExprOf = typename decay<decltype(asSetExpr(declval<const X&>()))>::type;
+
+template <typename L, typename R, typename = enable_if_t<IsSetOperand<L>::value && IsSetOperand<R>::value>>
+UnionExpr<SetExprOf<L>, SetExprOf<R>> operator|(const L& a, const R& b) {
+    return { asSetExpr(a), asSetExpr(b) };
+}
+
+template <typename L, typename R, typename = enable_if_t<IsSetOperand<L>::value && IsSetOperand<R>::value>>
+IntersectionExpr<SetExprOf<L>, SetExprOf<R>> operator&(const L& a, const R& b) {
+    return { asSetExpr(a), asSetExpr(b) };
+}
+
+template <typename L, typename R, typename = enable_if_t<IsSetOperand<L>::value && IsSetOperand<R>::value>>
+DifferenceExpr<SetExprOf<L>, SetExprOf<R>> operator-(const L& a, const R& b) {
+    return { asSetExpr(a), asSetExpr(b) };
+}
+
+template <typename L, typename R, typename = enable_if_t<IsSetOperand<L>::value && IsSetOperand<R>::value>>
+SymmetricDifferenceExpr<SetExprOf<L>, SetExprOf<R>> operator^(const L& a, const R& b) {
+    return { asSetExpr(a), asSetExpr(b) };
+}
+
+#endif
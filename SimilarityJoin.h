@@ -0,0 +1,198 @@
+#ifndef SIMILARITY_JOIN_H
+#define SIMILARITY_JOIN_H
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <cstdint>
+#include "Interner.h"
+#include "Parallel.h"
+using namespace std;
+
+// Similarity Join
+// All pairs of records (e.g. students' course sets) with Jaccard similarity
+// |x n y| / |x u y| >= t, without comparing every pair (PPJoin):
+//   - tokens are interned and renumbered rarest first, so the first few
+//     tokens of a sorted record (its prefix) are the selective ones
+//   - two records can only reach t if their prefixes share a token, so only
+//     prefixes are indexed and probed (prefix filter)
+//   - records are visited by size, and a record is only compared with
+//     smaller ones of at least t times its size (length filter)
+//   - a shared prefix token at positions i, j bounds the overlap by the
+//     tokens left after them; candidates that cannot reach t are dropped
+//     before verification (positional filter)
+// Probes are independent, so blocks of them run on worker threads.
+class SimilarityJoin {
+public:
+    struct Match {
+        size_t first, second;           // record indices, first < second
+        double similarity;
+    };
+
+private:
+    static constexpr size_t ProbeBlock = 256;
+
+    // Overlap needed for two records of sizes a and b to reach t
+    static size_t requiredOverlap(double t, size_t a, size_t b) {
+        return (size_t)ceil(t / (1 + t) * (double)(a + b) - 1e-9);
+    }
+
+    static size_t prefixLength(size_t size, double fraction) {
+        return size - (size_t)ceil(fraction * (double)size - 1e-9) + 1;
+    }
+
+    // |x n y|, or something below need as soon as need is out of reach
+    static size_t overlapUpTo(const uint32_t* x, size_t nx, const uint32_t* y, size_t ny, size_t need) {
+        size_t i = 0, j = 0, n = 0;
+        while (i < nx && j < ny) {
+            if (n + min(nx - i, ny - j) < need) return n;
+            uint32_t a = x[i], b = y[j];
+            n += a == b;
+            i += a <= b;
+            j += b <= a;
+        }
+        return n;
+    }
+
+public:
+    // Records of already interned ids (duplicates within a record are ignored)
+    static vector<Match> selfJoin(vector<vector<uint32_t>> records, double t, unsigned threads = 0) {
+        if (!(t > 0 && t <= 1)) throw runtime_error("Similarity threshold must be in (0, 1]");
+
+        // Renumber tokens by frequency, rarest first
+        uint32_t maxToken = 0;
+        for (auto& r : records) {
+            sort(r.begin(), r.end());
+            r.erase(unique(r.begin(), r.end()), r.end());
+            if (!r.empty()) maxToken = max(maxToken, r.back() + 1);
+        }
+        vector<uint32_t> frequency(maxToken, 0), rank(maxToken);
+        for (const auto& r : records) {
+            for (uint32_t x : r) frequency[x]++;
+        }
+        vector<uint32_t> byFrequency(maxToken);
+        for (uint32_t x = 0; x < maxToken; x++) byFrequency[x] = x;
+        stable_sort(byFrequency.begin(), byFrequency.end(), [&](uint32_t a, uint32_t b) { return frequency[a] < frequency[b]; });
+        for (uint32_t k = 0; k < maxToken; k++) rank[byFrequency[k]] = k;
+        for (auto& r : records) {
+            for (auto& x : r) x = rank[x];
+            sort(r.begin(), r.end());
+        }
+
+        // Visit order: by size; empty records have no similarity
+        vector<uint32_t> order;
+        for (uint32_t i = 0; i < records.size(); i++) {
+            if (!records[i].empty()) order.push_back(i);
+        }
+        stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return records[a].size() < records[b].size(); });
+        size_t n = order.size();
+
+        // Records laid out back to back in visit order
+        vector<size_t> begin(n + 1, 0);
+        for (size_t k = 0; k < n; k++) begin[k + 1] = begin[k] + records[order[k]].size();
+        vector<uint32_t> tokens;
+        tokens.reserve(begin[n]);
+        for (size_t k = 0; k < n; k++) tokens.insert(tokens.end(), records[order[k]].begin(), records[order[k]].end());
+        auto sizeOf = [&](size_t k) { return begin[k + 1] - begin[k]; };
+
+        // Index prefix tokens (shorter, since every probe is at least as large)
+        size_t largest = n ? sizeOf(n - 1) : 0;
+        vector<size_t> indexPrefix(largest + 1, 0);
+        for (size_t s = 1; s <= largest; s++) indexPrefix[s] = prefixLength(s, 2 * t / (1 + t));
+        vector<uint32_t> start(maxToken + 1, 0);
+        for (size_t k = 0; k < n; k++) {
+            for (size_t i = 0; i < indexPrefix[sizeOf(k)]; i++) start[tokens[begin[k] + i] + 1]++;
+        }
+        for (uint32_t x = 0; x < maxToken; x++) start[x + 1] += start[x];
+        vector<pair<uint32_t, uint32_t>> postings(start[maxToken]);     // (visit position, token position)
+        vector<uint32_t> fill(start.begin(), start.end() - 1);
+        vector<uint32_t> lastIndexed(n);
+        for (size_t k = 0; k < n; k++) {
+            size_t p = indexPrefix[sizeOf(k)];
+            for (size_t i = 0; i < p; i++) {
+                postings[fill[tokens[begin[k] + i]]++] = { (uint32_t)k, (uint32_t)i };
+            }
+            lastIndexed[k] = tokens[begin[k] + p - 1];
+        }
+
+        // Probe blocks are dealt round-robin: later (larger) records cost more
+        size_t blocks = (n + ProbeBlock - 1) / ProbeBlock;
+        unsigned workers = workerCount(blocks, 1, threads);
+        vector<vector<Match>> found(workers);
+        parallelFor(workers, workers, [&](size_t wBegin, size_t wEnd, unsigned) {
+            vector<int> count(n, 0);                // -1: ruled out by the positional filter
+            vector<uint32_t> touched;
+            vector<size_t> need;                    // required overlap by candidate size
+            for (size_t w = wBegin; w < wEnd; w++) {
+                for (size_t b = w; b < blocks; b += workers) {
+                    for (size_t k = b * ProbeBlock; k < min(n, (b + 1) * ProbeBlock); k++) {
+                        const uint32_t* y = tokens.data() + begin[k];
+                        size_t ny = sizeOf(k);
+                        size_t minSize = (size_t)ceil(t * (double)ny - 1e-9);
+                        need.resize(ny + 1);
+                        for (size_t s = minSize; s <= ny; s++) need[s] = requiredOverlap(t, s, ny);
+
+                        size_t py = prefixLength(ny, t);
+                        for (size_t j = 0; j < py; j++) {
+                            auto first = postings.begin() + start[y[j]], last = postings.begin() + start[y[j] + 1];
+                            first = lower_bound(first, last, minSize, [&](const pair<uint32_t, uint32_t>& p, size_t s) { return sizeOf(p.first) < s; });
+                            for (auto it = first; it != last && it->first < k; ++it) {
+                                uint32_t x = it->first;
+                                if (count[x] < 0) continue;
+                                if (count[x] == 0) touched.push_back(x);
+                                size_t nx = sizeOf(x);
+                                size_t bound = count[x] + 1 + min(nx - it->second - 1, ny - j - 1);
+                                if (bound >= need[nx]) count[x]++;
+                                else count[x] = -1;
+                            }
+                        }
+
+                        // Every match between the two prefixes is counted already, and
+                        // the record whose prefix ends on the smaller token has no
+                        // other matches in its prefix, so only suffixes are merged
+                        for (uint32_t x : touched) {
+                            if (count[x] > 0) {
+                                size_t nx = sizeOf(x), px = indexPrefix[nx], c = count[x];
+                                const uint32_t* xs = tokens.data() + begin[x];
+                                size_t common = c;
+                                if (y[py - 1] < lastIndexed[x]) {
+                                    if (c + ny - py >= need[nx]) common += overlapUpTo(y + py, ny - py, xs + c, nx - c, need[nx] - c);
+                                }
+                                else if (c + nx - px >= need[nx]) {
+                                    common += overlapUpTo(y + c, ny - c, xs + px, nx - px, need[nx] - c);
+                                }
+                                if (common >= need[nx]) {
+                                    size_t lo = min(order[x], order[k]), hi = max(order[x], order[k]);
+                                    found[w].push_back({ lo, hi, (double)common / (double)(nx + ny - common) });
+                                }
+                            }
+                            count[x] = 0;
+                        }
+                        touched.clear();
+                    }
+                }
+            }
+        });
+
+        vector<Match> matches;
+        for (auto& f : found) matches.insert(matches.end(), f.begin(), f.end());
+        sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+            return a.first != b.first ? a.first < b.first : a.second < b.second;
+        });
+        return matches;
+    }
+
+    // Records of names (course IDs), interned first
+    static vector<Match> selfJoin(const vector<vector<string>>& records, double t, unsigned threads = 0) {
+        IdInterner tokens;
+        vector<vector<uint32_t>> ids(records.size());
+        for (size_t i = 0; i < records.size(); i++) {
+            for (const auto& name : records[i]) ids[i].push_back(tokens.intern(name));
+        }
+        return selfJoin(move(ids), t, threads);
+    }
+};
+
+#endif
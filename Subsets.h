@@ -0,0 +1,220 @@
+#ifndef SUBSETS_H
+#define SUBSETS_H
+
+#include <set>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <cstdint>
+#include "Bits.h"
+#include "Parallel.h"
+using namespace std;
+
+// Subset View
+// One subset of an element vector, stored as a 64-bit mask (bit i set means
+// elements[i] is in the subset). Nothing is copied until toSet()/toVector().
+template <typename T>
+class SubsetView {
+private:
+    const vector<T>* elements;
+    uint64_t bits;
+
+public:
+    class const_iterator {
+    private:
+        const vector<T>* elements;
+        uint64_t rest;
+    public:
+        const_iterator(const vector<T>* e, uint64_t r) : elements(e), rest(r) {}
+        const T& operator*() const { return (*elements)[ctz64(rest)]; }
+        const_iterator& operator++() { rest &= rest - 1; return *this; }
+        bool operator!=(const const_iterator& other) const { return rest != other.rest; }
+    };
+
+    SubsetView(const vector<T>* e, uint64_t m) : elements(e), bits(m) {}
+
+    uint64_t mask() const { return bits; }
+    size_t size() const { return (size_t)popcount64(bits); }
+    bool containsIndex(size_t i) const { return bits >> i & 1; }
+    const_iterator begin() const { return const_iterator(elements, bits); }
+    const_iterator end() const { return const_iterator(elements, 0); }
+
+    set<T> toSet() const {
+        set<T> out;
+        for (const T& x : *this) out.insert(out.end(), x);
+        return out;
+    }
+
+    vector<T> toVector() const {
+        vector<T> out;
+        out.reserve(size());
+        for (const T& x : *this) out.push_back(x);
+        return out;
+    }
+};
+
+// Subsets
+// The subsets of up to 64 elements, produced on demand in order of size and,
+// within one size, in increasing mask order (Gosper's hack steps from one
+// k-subset mask to the next). A subset's position in that order can be turned
+// back into its mask (combinatorial number system), so any index range can be
+// visited on its own, which is how forEachParallel splits the work.
+//
+// Subsets<string> all(courses);                 // 2^n subsets
+// all.sizeBetween(2, 3).where(fitsSchedule);     // filtered, still lazy
+template <typename T>
+class Subsets {
+public:
+    using View = SubsetView<T>;
+    using Predicate = function<bool(const View&)>;
+
+    static constexpr size_t MaxElements = 64;
+
+private:
+    vector<T> elements;
+    size_t minSize, maxSize;
+    Predicate keep;
+    vector<vector<uint64_t>> choose;    // choose[n][k], n <= elements
+
+    static uint64_t firstMask(size_t k) { return k == 64 ? ~0ULL : (1ULL << k) - 1; }
+
+    // Next mask with the same number of bits
+    static uint64_t gosper(uint64_t m) {
+        uint64_t lowest = m & (~m + 1);
+        uint64_t ripple = m + lowest;
+        return (((ripple ^ m) >> 2) / lowest) | ripple;
+    }
+
+    void buildTable() {
+        if (elements.size() > MaxElements) {
+            throw runtime_error("Subsets: at most " + to_string(MaxElements) + " elements, got " + to_string(elements.size()));
+        }
+        size_t n = elements.size();
+        choose.assign(n + 1, vector<uint64_t>(n + 1, 0));
+        for (size_t i = 0; i <= n; i++) {
+            choose[i][0] = 1;
+            for (size_t k = 1; k <= i; k++) choose[i][k] = choose[i - 1][k - 1] + choose[i - 1][k];
+        }
+    }
+
+    // The rank-th k-subset mask in increasing mask order
+    uint64_t unrank(uint64_t rank, size_t k) const {
+        uint64_t m = 0;
+        for (size_t j = elements.size(); j-- > 0 && k > 0;) {
+            if (choose[j][k] <= rank) {
+                rank -= choose[j][k];
+                m |= 1ULL << j;
+                k--;
+            }
+        }
+        return m;
+    }
+
+    // The size at position index, and index made relative to that size
+    size_t sizeAt(uint64_t& index) const {
+        size_t k = minSize;
+        while (index >= choose[elements.size()][k]) index -= choose[elements.size()][k++];
+        return k;
+    }
+
+public:
+    explicit Subsets(vector<T> values) : elements(move(values)) {
+        buildTable();
+        minSize = 0;
+        maxSize = elements.size();
+    }
+
+    explicit Subsets(const set<T>& values) : Subsets(vector<T>(values.begin(), values.end())) {}
+
+    // Size filters narrow the order; they do not reorder it
+    Subsets& ofSize(size_t k) { return sizeBetween(k, k); }
+
+    Subsets& sizeBetween(size_t lo, size_t hi) {
+        if (lo > hi || hi > elements.size()) throw runtime_error("Subsets: invalid size range");
+        minSize = lo;
+        maxSize = hi;
+        return *this;
+    }
+
+    // Predicates are checked while iterating; count() does not apply them
+    Subsets& where(Predicate p) {
+        if (keep) {
+            Predicate before = move(keep);
+            keep = [before, p](const View& v) { return before(v) && p(v); };
+        }
+        else {
+            keep = move(p);
+        }
+        return *this;
+    }
+
+    const vector<T>& items() const { return elements; }
+
+    // Subsets in the size range; throws if that is 2^64 (all subsets of 64 elements)
+    uint64_t count() const {
+        uint64_t total = 0;
+        for (size_t k = minSize; k <= maxSize; k++) {
+            uint64_t c = choose[elements.size()][k];
+            if (total + c < total) throw runtime_error("Subsets: count does not fit in 64 bits");
+            total += c;
+        }
+        return total;
+    }
+
+    // Mask of the subset at position index
+    uint64_t maskAt(uint64_t index) const {
+        size_t k = sizeAt(index);
+        return unrank(index, k);
+    }
+
+    View at(uint64_t index) const { return View(&elements, maskAt(index)); }
+
+    // Visits positions [begin, end) that pass the predicate; fn returns false to stop
+    template <typename Fn>
+    bool forEachInRange(uint64_t begin, uint64_t end, Fn fn) const {
+        if (begin >= end) return true;
+        uint64_t index = begin;
+        size_t k = sizeAt(index);
+        uint64_t left = choose[elements.size()][k] - index;
+        uint64_t m = unrank(index, k);
+
+        for (uint64_t i = begin; i < end; i++) {
+            View v(&elements, m);
+            if (!keep || keep(v)) {
+                if (!fn(v)) return false;
+            }
+            if (i + 1 == end) break;
+            if (--left == 0) {
+                k++;
+                left = choose[elements.size()][k];
+                m = firstMask(k);
+            }
+            else {
+                m = gosper(m);
+            }
+        }
+        return true;
+    }
+
+    template <typename Fn>
+    bool forEach(Fn fn) const { return forEachInRange(0, count(), fn); }
+
+    // Splits the positions into one contiguous chunk per worker; fn(view, worker)
+    template <typename Fn>
+    void forEachParallel(Fn fn, unsigned threads = 0, size_t minPerWorker = 4096) const {
+        uint64_t n = count();
+        parallelFor((size_t)n, workerCount((size_t)n, minPerWorker, threads), [&](size_t begin, size_t end, unsigned w) {
+            forEachInRange(begin, end, [&](const View& v) { fn(v, w); return true; });
+        });
+    }
+
+    // Subsets passing the predicate (visits every candidate)
+    uint64_t countMatching() const {
+        uint64_t total = 0;
+        forEach([&](const View&) { total++; return true; });
+        return total;
+    }
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+// Tracing
+// Verification routines narrate their proofs through a TraceSink instead of
+// writing to cout directly. They check wants() before formatting anything, so
+// with tracing off no text is built at all.
+enum class TraceLevel { Off = 0, Summary = 1, Proof = 2 };
+
+class TraceSink {
+protected:
+    TraceLevel level;
+
+public:
+    explicit TraceSink(TraceLevel level = TraceLevel::Proof) : level(level) {}
+    virtual ~TraceSink() {}
+
+    TraceLevel getLevel() const { return level; }
+    void setLevel(TraceLevel l) { level = l; }
+
+    bool wants(TraceLevel l) const {
+        return l != TraceLevel::Off && (int)l <= (int)level;
+    }
+
+    // Stream for the next trace line; only valid to use when wants() is true
+    virtual ostream& stream() = 0;
+    virtual void flush() {}
+};
+
+// Collects narration in a fixed block and writes it to the target in large
+// pieces (on flush, or whenever the block fills) instead of once per line.
+// The block lives in the stream buffer itself, so a caller may hold on to
+// stream() for a whole proof and memory still stays at the limit.
+class BufferedTraceSink : public TraceSink {
+private:
+    class BlockBuffer : public streambuf {
+    private:
+        ostream& target;
+        vector<char> block;
+
+        void drain() {
+            if (pptr() > pbase()) target.write(pbase(), pptr() - pbase());
+            setp(block.data(), block.data() + block.size());
+        }
+
+    protected:
+        int_type overflow(int_type ch) override {
+            drain();
+            if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+                *pptr() = traits_type::to_char_type(ch);
+                pbump(1);
+            }
+            return traits_type::not_eof(ch);
+        }
+
+        int sync() override {
+            drain();
+            return 0;
+        }
+
+    public:
+        BlockBuffer(ostream& target, size_t limit) : target(target), block(max<size_t>(limit, 1)) {
+            setp(block.data(), block.data() + block.size());
+        }
+    };
+
+    BlockBuffer blocks;
+    ostream out;
+
+public:
+    BufferedTraceSink(ostream& target, TraceLevel level = TraceLevel::Proof,
+        size_t limit = 1 << 16)
+        : TraceSink(level), blocks(target, limit), out(&blocks) {
+    }
+
+    ~BufferedTraceSink() { flush(); }
+
+    ostream& stream() override { return out; }
+
+    void flush() override { out.flush(); }
+};
+
+// Keeps everything it receives, e.g. to store or inspect a proof later
+class MemoryTraceSink : public TraceSink {
+private:
+    ostringstream buffer;
+
+public:
+    explicit MemoryTraceSink(TraceLevel level = TraceLevel::Proof) : TraceSink(level) {}
+
+    ostream& stream() override { return buffer; }
+    string str() const { return buffer.str(); }
+    void clear() { buffer.str(""); buffer.clear(); }
+};
+
+// Default sink used by every module: full proofs on the console
+inline TraceSink& consoleTrace() {
+    static BufferedTraceSink sink(cout, TraceLevel::Proof);
+    return sink;
+}
+
+// Sink that never asks for events
+inline TraceSink& silentTrace() {
+    static MemoryTraceSink sink(TraceLevel::Off);
+    return sink;
+}
+
+#endif
@@ -7,6 +7,14 @@
 #include <map>
 #include <string>
 #include <limits>
+#include <random>
+#include "Induction.h"
+#include "Logic.h"
+#include "Population.h"
+#include "RuleLoader.h"
+#include "Set.h"
+#include "Relation.h"
+#include "Scheduling.h"
 using namespace std;
 
 // Unit Testing
@@ -68,6 +76,126 @@ public:
         set<int> C = { 2, 3 };
         bool isSubset = includes(A.begin(), A.end(), C.begin(), C.end());
         test(isSubset, "Subset Test");
+
+        // Flat sets: SIMD intersection on int keys, std::set adapter
+        vector<int> evens, triples;
+        for (int k = 0; k < 3000; k += 2) evens.push_back(k);
+        for (int k = 0; k < 3000; k += 3) triples.push_back(k);
+        FlatSet<int> E(evens), T3(triples);
+        auto common = SetOperations<int>::setIntersection(E, T3);
+        test(common.size() == 500, "Flat Set SIMD Intersection Size");
+        test(common.contains(2994) && !common.contains(2995), "Flat Set Membership");
+        test(SetOperations<int>::isSubset(common, E), "Flat Set Subset");
+        test(SetOperations<int>::setUnion(E, T3).size() == 2000, "Flat Set Union Size");
+        test(SetOperations<int>::setIntersection(A, B) == set<int>{ 2, 3 }, "Flat Set std::set Adapter");
+
+        // Compressed bitmaps: bitmap, run and array containers mixed
+        vector<uint32_t> evenIds, block;
+        for (uint32_t k = 0; k < 200000; k += 2) evenIds.push_back(k);
+        for (uint32_t k = 70000; k < 80000; k++) block.push_back(k);
+        RoaringBitmap Ev(evenIds), Bl(block), few{ 3, 70001, 500000 };
+        Bl.runOptimize();
+        using IdSets = SetOperations<uint32_t>;
+        test(IdSets::cardinality(IdSets::setIntersection(Ev, Bl)) == 5000, "Roaring Bitmap Intersection");
+        test(IdSets::intersectionCardinality(Ev, Bl) == 5000, "Roaring Bitmap Intersection Count");
+        test(IdSets::setUnion(Ev, Bl).size() == 105000, "Roaring Bitmap Union");
+        test(IdSets::setDifference(Bl, Ev).size() == 5000, "Roaring Bitmap Difference");
+        test(IdSets::setIntersection(Ev, few).toVector().empty(), "Roaring Bitmap Array Miss");
+        test(IdSets::setIntersection(Bl, few).toVector() == vector<uint32_t>{ 70001 }, "Roaring Bitmap Run And Array");
+        test(IdSets::isSubset(IdSets::setIntersection(Ev, Bl), Bl) && !IdSets::isSubset(few, Ev), "Roaring Bitmap Subset");
+        test(Bl.sizeInBytes() < 100, "Roaring Bitmap Run Container Size");
+
+        // Lazy subsets: k-subsets of 25 courses, positions split across workers
+        vector<int> catalog;
+        for (int k = 0; k < 25; k++) catalog.push_back(k);
+        Subsets<int> trios(catalog);
+        trios.ofSize(3).where([](const SubsetView<int>& s) { return s.containsIndex(0); });
+        vector<uint64_t> perWorker(4, 0);
+        trios.forEachParallel([&](const SubsetView<int>&, unsigned w) { perWorker[w]++; }, 4, 1);
+        Subsets<int> wide(vector<int>(64, 0));
+        test(trios.count() == 2300, "Lazy Subset Count");
+        test(trios.countMatching() == 276, "Lazy Subset Filter");
+        test(perWorker[0] + perWorker[1] + perWorker[2] + perWorker[3] == 276, "Lazy Subset Parallel Scan");
+        test(trios.at(2299).toVector() == vector<int>{ 22, 23, 24 }, "Lazy Subset Indexing");
+        test(wide.ofSize(32).count() == 1832624140942590534ULL, "Lazy Subset 64-Bit Count");
+        test(SetOperations<int>::powerSet(A).size() == 8, "Power Set Size");
+
+        // Lazy products: indexed pairs, parallel scan, n-ary tuples
+        vector<string> slotNames = { "Mon", "Tue", "Wed" };
+        CartesianProduct<int, string> studentSlots(catalog, slotNames);
+        vector<uint64_t> pairsPerWorker(4, 0);
+        studentSlots.forEachParallel([&](int, const string&, unsigned w) { pairsPerWorker[w]++; }, 4, 1);
+        NaryProduct<int> grid(vector<vector<int>>{ { 1, 2 }, { 10, 20, 30 }, { 100, 200 } });
+        test(studentSlots.size() == 75, "Lazy Cartesian Product Size");
+        test(studentSlots.at(31).first == 10 && studentSlots.at(31).second == "Tue", "Lazy Cartesian Product Indexing");
+        test(pairsPerWorker[0] + pairsPerWorker[1] + pairsPerWorker[2] + pairsPerWorker[3] == 75,
+            "Lazy Cartesian Product Parallel Scan");
+        test(grid.size() == 12 && grid.at(7) == vector<int>{ 2, 10, 200 }, "N-ary Product Indexing");
+        test(SetOperations<int>::cartesianProduct(A, B).size() == 9, "Cartesian Product Size");
+
+        // k-way: smallest roster drives the intersection
+        FlatSet<int> Ev2(evens), T32(triples), Fives{ 0, 5, 6, 30, 600, 2995, 2996 };
+        vector<const FlatSet<int>*> rosters = { &Ev2, &T32, &Fives };
+        test(SetOperations<int>::setIntersection(rosters) == FlatSet<int>{ 0, 6, 30, 600 }, "Multi-Way Intersection");
+        test(SetOperations<int>::setUnion(rosters).size() == 2002, "Multi-Way Union");
+        test(SetOperations<int>::setIntersection(vector<const FlatSet<int>*>{ &Fives }) == Fives,
+            "Multi-Way Intersection Of One Set");
+
+        // Merge-path slices: forced to 7 workers, checked against one pass
+        vector<int> m1, m2;
+        for (int k = 0; k < 600000; k++) {
+            m1.push_back(k * 2);
+            m2.push_back(k * 3);
+        }
+        FlatSet<int> M1(m1), M2(m2);
+        auto parCommon = SetOperations<int>::parallelIntersection(M1, M2, 7);
+        test(SetOperations<int>::parallelUnion(M1, M2, 7) == FlatSet<int>::unionOf(M1, M2), "Parallel Merge-Path Union");
+        test(parCommon == FlatSet<int>::intersectionOf(M1, M2) && parCommon.size() == 200000,
+            "Parallel Merge-Path Intersection");
+        test(SetOperations<int>::parallelDifference(M2, M1, 7) == FlatSet<int>::differenceOf(M2, M1),
+            "Parallel Merge-Path Difference");
+
+        // Jaccard join: identical, 3/5 overlap, disjoint and empty records
+        vector<vector<string>> courseSets = {
+            { "CS101", "CS201", "MT101" }, { "CS101", "CS201", "MT101" },
+            { "CS101", "CS201", "MT101", "PH101", "EN101" }, { "AR101" }, { } };
+        auto close = SimilarityJoin::selfJoin(courseSets, 0.6, 2);
+        auto exact = SimilarityJoin::selfJoin(courseSets, 1.0);
+        test(close.size() == 3, "Jaccard Join Pair Count");
+        test(close[0].first == 0 && close[0].second == 1 && close[0].similarity == 1.0, "Jaccard Join Identical Records");
+        test(close[2].first == 1 && close[2].second == 2, "Jaccard Join Partial Overlap");
+        test(exact.size() == 1, "Jaccard Join Exact Threshold");
+        test(SimilarityJoin::selfJoin(courseSets, 0.61).size() == 1, "Jaccard Join Just Above Overlap");
+
+        // Set expressions: fused, counted without building the result
+        FlatSet<int> X1{ 1, 2, 3, 4 }, X2{ 3, 4, 5, 6 }, X3{ 2, 4, 6, 8 }, X4{ 4 };
+        auto fused = ((X1 | X2) & X3) - X4;
+        test(fused.toFlatSet() == FlatSet<int>{ 2, 6 }, "Set Expression Evaluation");
+        test(SetOperations<int>::cardinality((X1 | X2) & X3) == 3, "Set Expression Cardinality");
+        test((X1 ^ X2).toFlatSet() == FlatSet<int>{ 1, 2, 5, 6 }, "Set Expression Symmetric Difference");
+        test(fused.contains(6) && !fused.contains(4), "Set Expression Membership");
+        test(SetOperations<int>::setSymmetricDifference(A, B) == set<int>{ 1, 4 }, "Symmetric Difference");
+
+        // Sketches: 20000 + 20000 students sharing 5000, within a few percent
+        EnrollmentSketches sketches;
+        for (int k = 0; k < 20000; k++) {
+            sketches.recordEnrollment("S" + to_string(k), "CS101");
+            sketches.recordEnrollment("S" + to_string(k + 15000), "MT101");
+        }
+        double anyCourse = sketches.distinctStudents({ "CS101", "MT101" });
+        double both = sketches.overlap({ "CS101" }, { "MT101" });
+        test(fabs(sketches.students("CS101") - 20000) < 1000, "HyperLogLog Course Estimate");
+        test(fabs(anyCourse - 35000) < 1750, "HyperLogLog Union Estimate");
+        test(fabs(both - 5000) < 2500, "HyperLogLog Overlap Estimate");
+        test(sketches.students("EN101") == 0, "HyperLogLog Unknown Course");
+        bool capped = false;
+        try {
+            sketches.studentsInAll({ "CS101", "MT101", "PH101", "EN101", "AR101" });
+        }
+        catch (const runtime_error&) {
+            capped = true;
+        }
+        test(capped, "HyperLogLog All-Courses Cap");
     }
 
     // Test Combinations
@@ -124,6 +252,30 @@ public:
             }
         }
         test(!symmetric, "Non-Symmetric Relation (A->B but not all symmetric)");
+
+        // Bit-matrix checks: a 200-course chain is not transitive, its closure is
+        Relations<int> chain;
+        for (int c = 0; c < 200; c++) chain.addRelation(c, c + 1);
+        Relations<int> closure = chain.transitiveClosure();
+        test(!chain.isTransitive(), "Bit Matrix Chain Not Transitive");
+        test(closure.isTransitive(), "Transitive Closure Is Transitive");
+        test(!closure.isSymmetric(), "Transitive Closure Not Symmetric");
+        test(closure.getRelations().size() == 201 * 200 / 2, "Transitive Closure Size");
+        test(closure.hasRelation(0, 200) && !closure.hasRelation(200, 0), "Transitive Closure Direction");
+
+        // 60000 elements would need a 450 MB matrix; checked on the pairs instead
+        Relations<int> sparse;
+        for (int k = 0; k < 20000; k++) {
+            sparse.addRelation(3 * k, 3 * k + 1);
+            sparse.addRelation(3 * k + 1, 3 * k + 2);
+        }
+        Relations<int> sparseClosure = sparse.transitiveClosure();
+        test(!sparse.isTransitive(), "Sparse Relation Not Transitive");
+        test(!sparse.isReflexive(), "Sparse Relation Not Reflexive");
+        test(!sparse.isSymmetric(), "Sparse Relation Not Symmetric");
+        test(sparseClosure.getRelations().size() == 60000, "Sparse Transitive Closure Size");
+        test(sparseClosure.hasRelation(0, 2) && !sparseClosure.hasRelation(2, 3), "Sparse Transitive Closure Pairs");
+        test(sparseClosure.isTransitive(), "Sparse Transitive Closure Is Transitive");
     }
 
     // Test Functions
@@ -170,6 +322,259 @@ public:
         // Implication
         bool implies = !p || q;
         test(implies == false, "Implication (T ? F = F)");
+
+        // Long chain added back to front, well past the old iteration cap
+        LogicEngine engine;
+        engine.setTraceSink(silentTrace());
+        for (int i = 49; i >= 0; i--) {
+            engine.addRule("step" + to_string(i), "step" + to_string(i + 1));
+        }
+        engine.addFact("step0");
+        engine.infer();
+        test(engine.isFact("step50"), "Inference Reaches Fixpoint");
+
+        engine.addRule("step50", "done");
+        engine.infer();
+        test(engine.isFact("done") && !engine.isFact("unrelated"), "Late Rule Fires On Known Fact");
+
+        // Compound conditions; the second rule reuses x AND y
+        LogicEngine policy;
+        policy.setTraceSink(silentTrace());
+        policy.parseRule("IF x AND y THEN p");
+        policy.parseRule("IF (y AND x) OR NOT z THEN q");
+        policy.parseRule("IF p AND NOT q THEN r");
+        test(policy.conditionNodeCount() == 10, "Shared Condition Nodes");
+
+        policy.addFact("x");
+        policy.addFact("y");
+        policy.addFact("z");
+        policy.infer();
+        test(policy.isFact("p"), "Compound Rule AND");
+        test(policy.isFact("q"), "Compound Rule OR With NOT");
+        test(!policy.isFact("r"), "Compound Rule AND NOT");
+
+        // Backward chaining: cyclic rules, nothing materialised, re-asked after a new fact
+        LogicEngine goals;
+        goals.setTraceSink(silentTrace());
+        goals.addRule("a", "b");
+        goals.addRule("b", "a");
+        goals.addRule("b AND c", "goal");
+        bool before = goals.query("goal");
+        goals.addFact("a");
+        goals.addFact("c");
+        test(!before, "Backward Chaining Query Before Facts");
+        test(goals.query("goal"), "Backward Chaining Query");
+        test(!goals.isFact("goal"), "Backward Chaining Leaves Facts Alone");
+
+        // NOT b is read only once b's stratum is finished, as infer() does
+        LogicEngine negated;
+        negated.setTraceSink(silentTrace());
+        negated.addRule("NOT b", "goal");
+        negated.addRule("a", "b");
+        negated.addFact("a");
+        test(!negated.query("goal"), "Backward Chaining Respects Strata");
+        negated.infer();
+        test(!negated.isFact("goal"), "Backward Chaining Agrees With Inference");
+
+        // SAT: 4 students cannot fit 3 single seats, 3 can
+        auto pigeons = [](int p, int h) {
+            SatSolver sat;
+            for (int v = 0; v < p * h; v++) sat.newVar();
+            for (int i = 0; i < p; i++) {
+                vector<int> somewhere;
+                for (int j = 0; j < h; j++) somewhere.push_back(SatSolver::lit(i * h + j));
+                sat.addClause(somewhere);
+            }
+            for (int j = 0; j < h; j++)
+                for (int a = 0; a < p; a++)
+                    for (int b = a + 1; b < p; b++)
+                        sat.addClause({ SatSolver::lit(a * h + j, true), SatSolver::lit(b * h + j, true) });
+            return sat.solve();
+        };
+        test(pigeons(4, 3) == SatSolver::Unsatisfiable, "CDCL Pigeonhole Unsatisfiable");
+        test(pigeons(3, 3) == SatSolver::Satisfiable, "CDCL Pigeonhole Satisfiable");
+
+        // An indirect contradiction, reported with only the rules and facts behind it
+        LogicEngine audit;
+        audit.setTraceSink(silentTrace());
+        audit.addRule("enrolled", "has_seat");
+        audit.addRule("has_seat AND waitlisted", "NOT_enrolled");
+        audit.addRule("audit", "report");
+        audit.addFact("enrolled");
+        audit.addFact("waitlisted");
+        audit.addFact("audit");
+        auto report = audit.checkConsistency();
+        test(!report.consistent, "SAT Consistency Contradiction");
+        test(report.core.size() == 4, "SAT Consistency Unsat Core");
+
+        // Retraction keeps what has another support and undoes the rest
+        LogicEngine tms;
+        tms.setTraceSink(silentTrace());
+        tms.addRule("fee_paid OR scholarship", "paid");
+        tms.addRule("enrolled AND paid", "registered");
+        tms.addRule("NOT enrolled", "seat_free");
+        tms.addFact("enrolled");
+        tms.addFact("fee_paid");
+        tms.addFact("scholarship");
+        tms.infer();
+        test(tms.retractFact("fee_paid") == 1, "Retraction Count");
+        test(tms.isFact("registered") && tms.isDerived("paid"), "Retraction Keeps Alternative Support");
+        test(tms.retractFact("enrolled") == 2, "Retraction Withdraws Dependents");
+        test(!tms.isFact("registered"), "Retraction Undoes Conclusion");
+        test(tms.isFact("seat_free"), "Retraction Enables NOT Condition");
+
+        // A new fact withdraws what was concluded from its absence
+        LogicEngine absent;
+        absent.setTraceSink(silentTrace());
+        absent.addRule("NOT a", "b");
+        absent.addRule("b", "c");
+        absent.addRule("x", "d");
+        absent.addRule("NOT a OR x", "d");
+        absent.addFact("x");
+        absent.infer();
+        absent.addFact("a");
+        absent.infer();
+        test(!absent.isFact("b") && !absent.isDerived("b"), "New Fact Withdraws Negated Support");
+        test(!absent.isFact("c"), "New Fact Withdraws Dependents");
+        test(absent.isFact("d"), "New Fact Keeps Alternative Support");
+
+        // Same when the atom under NOT is derived by a later infer()
+        LogicEngine later;
+        later.setTraceSink(silentTrace());
+        later.addRule("NOT x", "d");
+        later.addRule("y", "x");
+        later.addRule("d", "e");
+        later.infer();
+        bool earlier = later.isFact("d") && later.isFact("e");
+        later.addFact("y");
+        later.infer();
+        test(earlier && later.isFact("x"), "Derived Atom Under NOT");
+        test(!later.isFact("d") && !later.isDerived("d"), "Derived Atom Withdraws Negated Support");
+        test(!later.isFact("e"), "Derived Atom Withdraws Dependents");
+
+        // The same rules for 200 students at once, one bit per student
+        LogicEngine rules;
+        rules.setTraceSink(silentTrace());
+        rules.addRule("enrolled AND (fee_paid OR scholarship)", "registered");
+        rules.addRule("registered AND NOT on_hold", "can_attend");
+        rules.addRule("on_hold", "NOT_registered");
+        for (const char* f : { "enrolled", "fee_paid", "scholarship", "on_hold" }) rules.addFact(f, false);
+        PopulationEvaluator population(rules);
+        vector<string> everyone, payers;
+        for (int i = 0; i < 200; i++) {
+            everyone.push_back("S" + to_string(i));
+            if (i % 2 == 0) payers.push_back("S" + to_string(i));
+        }
+        population.setFacts("enrolled", everyone);
+        population.setFacts("fee_paid", payers);
+        population.setFact("S0", "on_hold");
+        population.run();
+        test(population.count("registered") == 100, "Population Rule Count");
+        test(population.count("can_attend") == 99, "Population NOT Condition");
+        test(population.derivedFacts("S2").size() == 2, "Population Derived Facts");
+        test(population.conflictedStudents() == vector<string>{ "S0" }, "Population Conflicts");
+
+        // Rules added after the NOT that reads them still run first, as in infer()
+        LogicEngine reversed;
+        reversed.setTraceSink(silentTrace());
+        reversed.addRule("NOT b", "d");
+        reversed.addRule("a", "b");
+        PopulationEvaluator ordered(reversed);
+        ordered.setFacts("a", { "S0", "S1" });
+        ordered.addStudent("S2");
+        ordered.run();
+        reversed.addFact("a");
+        reversed.infer();
+        test(ordered.holds("S0", "d") == reversed.isFact("d"), "Population Matches Stratified Inference");
+        test(ordered.count("d") == 1 && ordered.holds("S2", "d"), "Population NOT Reads Final Column");
+
+        LogicEngine cyclic;
+        cyclic.setTraceSink(silentTrace());
+        cyclic.addRule("NOT q", "p");
+        cyclic.addRule("p", "q");
+        bool rejected = false;
+        try {
+            PopulationEvaluator unordered(cyclic);
+        }
+        catch (const runtime_error&) {
+            rejected = true;
+        }
+        test(rejected, "Population Rejects Unstratified Rules");
+
+        // Strata run once in order, so NOT sees the finished lower stratum
+        LogicEngine strata;
+        strata.setTraceSink(silentTrace());
+        strata.addRule("NOT registered", "seat_free");
+        strata.addRule("enrolled AND paid", "registered");
+        strata.addRule("enrolled AND paid AND advised", "registered");
+        strata.addRule("prereq_met", "eligible");
+        strata.addRule("eligible", "prereq_met");
+        strata.addRule("alumni", "discount");
+        strata.addFact("enrolled");
+        strata.addFact("paid");
+        strata.addFact("advised");
+        strata.infer();
+        auto analysis = strata.analyzeRules();
+        test(strata.isFact("registered") && !strata.isFact("seat_free"), "Stratified Inference");
+        test(analysis.stratified && analysis.strata == 2, "Rule Base Strata");
+        test(analysis.cycles.size() == 1, "Rule Base Cycles");
+        test(analysis.deadRules.size() == 3, "Rule Base Dead Rules");
+        test(analysis.subsumedRules.size() == 1, "Rule Base Subsumed Rules");
+
+        // Bulk loading: comments, facts, and bad lines reported by number
+        LogicEngine loaded;
+        loaded.setTraceSink(silentTrace());
+        auto load = RuleFileLoader::loadText(loaded,
+            "# registration policy\n"
+            "IF enrolled AND (fee paid OR scholarship) THEN registered\n"
+            "FACT enrolled\r\n"
+            "IF registered AND THEN clash\n"
+            "\n"
+            "FACT fee paid\n"
+            "IF registered THEN can attend\n");
+        loaded.infer();
+        test(load.lines == 7, "Rule File Line Count");
+        test(load.rules == 2 && load.facts == 2, "Rule File Rules And Facts");
+        test(load.errors.size() == 1 && load.errors[0].line == 4, "Rule File Error Line");
+        test(loaded.isFact("can_attend"), "Rule File Inference");
+
+        // Explanations pick the shortest well-founded derivation
+        LogicEngine audit2;
+        audit2.setTraceSink(silentTrace());
+        audit2.addRule("enrolled AND (fee_paid OR scholarship)", "registered");
+        audit2.addRule("a1 AND a2 AND a3", "fee_paid");
+        audit2.addRule("registered AND NOT on_hold", "can_attend");
+        for (const char* f : { "enrolled", "a1", "a2", "a3", "scholarship" }) audit2.addFact(f);
+        audit2.infer();
+        auto why = audit2.explain("can_attend");
+        test(why.size() == 4 && why.back().fact == "can_attend", "Explanation Length");
+        test(why[2].fact == "registered" && why[2].premises == vector<string>{ "enrolled", "scholarship" },
+            "Explanation Shortest Derivation");
+        test(audit2.explain("on_hold").empty(), "Explanation Of Unknown Fact");
+
+        // Datalog: one rule for every student, plus a recursive closure
+        DatalogEngine datalog;
+        datalog.addClause("prereq(CS201, CS101).");
+        datalog.addClause("prereq(CS301, CS201).");
+        datalog.addClause("completed(S1, CS101).");
+        datalog.addClause("completed(S2, CS201).");
+        datalog.addClause("eligible(S, C) :- completed(S, P), prereq(C, P).");
+        datalog.addClause("requires(C, P) :- prereq(C, P).");
+        datalog.addClause("requires(C, Q) :- requires(C, P), prereq(P, Q).");
+        datalog.run();
+        test(datalog.holds("eligible", { "S1", "CS201" }) && datalog.holds("eligible", { "S2", "CS301" }),
+            "Datalog Rule Over All Students");
+        test(datalog.count("eligible") == 2, "Datalog Rule Count");
+        test(datalog.holds("requires", { "CS301", "CS101" }), "Datalog Recursive Closure");
+        test(datalog.count("requires") == 3, "Datalog Closure Count");
+
+        // Both body atoms see the new edges in round one; each pair is still joined once
+        DatalogEngine hops;
+        for (const char* e : { "edge(a, b).", "edge(b, c).", "edge(c, d)." }) hops.addClause(e);
+        hops.addClause("two(X, Z) :- edge(X, Y), edge(Y, Z).");
+        auto hopStats = hops.run();
+        test(hopStats.produced == 2, "Datalog Semi-Naive Joins Once");
+        test(hops.count("two") == 2, "Datalog Two-Hop Count");
     }
 
     // Test Prerequisites (Induction concept)
@@ -203,6 +608,41 @@ public:
             }
         }
         test(!canTake, "Missing Prerequisite Detection");
+
+        // Diamond DAG: each shared prerequisite is expanded once
+        InductionVerifier verifier;
+        verifier.addPrerequisite("CS401", "CS301");
+        verifier.addPrerequisite("CS401", "Math301");
+        verifier.addPrerequisite("CS301", "CS201");
+        verifier.addPrerequisite("Math301", "CS201");
+        verifier.addPrerequisite("CS201", "CS101");
+        auto result = verifier.evaluateStrongInduction("CS401", { "CS101" });
+        test(!result.satisfied, "Strong Induction Unsatisfied");
+        test(result.visited == 4, "Strong Induction Memoized Walk");
+        test(result.frontier == vector<string>{ "CS201" }, "Strong Induction Missing Frontier");
+
+        // Batch chain verification reports each out-of-order prerequisite
+        auto report = verifier.verifyChainsBatch({
+            { "CS101", "CS201", "CS301", "Math301", "CS401" },
+            { "CS101", "CS301", "CS201" } });
+        test(report.valid == vector<char>{ 1, 0 }, "Batch Chain Verification");
+        test(report.violations.size() == 1 && report.violations[0].position == 1, "Batch Chain Violation Position");
+
+        // Summary-level tracing keeps the verdict but skips the proof steps
+        MemoryTraceSink summary(TraceLevel::Summary);
+        verifier.setTraceSink(summary);
+        bool valid = verifier.verifyPrerequisiteChain({ "CS101", "CS201" });
+        test(valid && summary.str().find("VALID") != string::npos, "Trace Sink Summary Verdict");
+        test(summary.str().find("BASE CASE") == string::npos, "Trace Sink Summary Level");
+
+        // A held stream still hands full blocks to the target
+        ostringstream console;
+        BufferedTraceSink buffered(console, TraceLevel::Proof, 64);
+        ostream& narration = buffered.stream();
+        for (int line = 0; line < 20; line++) narration << "step " << line << "\n";
+        test(console.str().size() >= 64, "Trace Sink Flushes When Full");
+        buffered.flush();
+        test(console.str().find("step 19") != string::npos, "Trace Sink Flush");
     }
 
     // Test Consistency
@@ -291,6 +731,71 @@ public:
             if (!validSequence) break;
         }
         test(!validSequence, "Invalid Course Sequence Detection");
+
+        // CS101 < CS201 < CS301 with Math101 free: 4 valid orderings
+        CourseScheduler scheduler;
+        scheduler.addPrerequisite("CS201", "CS101");
+        scheduler.addPrerequisite("CS301", "CS201");
+        scheduler.addCourse("Math101");
+        LinearExtensions orderings(scheduler.buildGraph());
+        test(orderings.count().toString() == "4", "Count Valid Orderings");
+
+        // Independent chains of 3 and 4 courses interleave in C(7, 3) ways
+        map<string, set<string>> twoChains = {
+            { "A2", { "A1" } }, { "A3", { "A2" } },
+            { "B2", { "B1" } }, { "B3", { "B2" } }, { "B4", { "B3" } } };
+        LinearExtensions parallel(PrerequisiteGraph::build(twoChains));
+        test(parallel.count().toString() == "35", "Count Parallel Chains");
+
+        // Two 11-course chains tied by A1 < B11: one connected block of 22,
+        // counted over sparse downsets; only "all B before all A" is lost
+        map<string, set<string>> tied;
+        for (int k = 2; k <= 11; k++) {
+            tied["A" + to_string(k)].insert("A" + to_string(k - 1));
+            tied["B" + to_string(k)].insert("B" + to_string(k - 1));
+        }
+        tied["B11"].insert("A1");
+        LinearExtensions sparse(PrerequisiteGraph::build(tied));
+        test(sparse.count().toString() == "705431", "Count Orderings Of Large Block");
+
+        // Sampled orderings place every prerequisite first
+        auto respects = [](const vector<string>& order, const map<string, set<string>>& reqs) {
+            map<string, size_t> position;
+            for (size_t i = 0; i < order.size(); i++) position[order[i]] = i;
+            for (const auto& entry : reqs)
+                for (const auto& p : entry.second)
+                    if (!position.count(p) || !position.count(entry.first) || position[p] > position[entry.first]) return false;
+            return true;
+        };
+        mt19937_64 rng(7);
+        bool sampledValid = true;
+        for (int k = 0; k < 50; k++) {
+            sampledValid = sampledValid && respects(parallel.sampleNames(rng), twoChains) &&
+                respects(sparse.sampleNames(rng), tied);
+        }
+        test(sampledValid, "Sampled Ordering Respects Prerequisites");
+
+        // Incremental eligibility frontier
+        EligibilityTracker tracker(scheduler.buildGraph());
+        tracker.addStudent("S001");
+        tracker.recordCompletion("S001", "CS101");
+        tracker.recordEnrollment("S001", "Math101");
+        test(tracker.nextCourses("S001") == vector<string>{ "CS201" }, "Eligibility Frontier Update");
+        test(!tracker.canTake("S001", "CS301"), "Eligibility Missing Prerequisite");
+
+        // Dropping puts the course back; revoking a completion closes its dependents
+        tracker.recordDrop("S001", "Math101");
+        test(tracker.canTake("S001", "Math101"), "Eligibility Drop");
+        tracker.revokeCompletion("S001", "CS101");
+        test(!tracker.canTake("S001", "CS201"), "Eligibility Revoked Completion");
+        test(tracker.canTake("S001", "CS101"), "Eligibility Revoked Course Reopens");
+
+        // The scheduler's tracker follows the record it is given
+        Student sophomore("T001", "Test");
+        test(scheduler.getAvailableCourses(sophomore) == vector<string>{ "CS101", "Math101" }, "Eligibility From Student Record");
+        sophomore.enrollCourse("CS101");
+        test(scheduler.getAvailableCourses(sophomore) == scheduler.getAvailableCourses(sophomore.getCourses()),
+            "Eligibility Follows Changed Record");
     }
 
     void runAllTests() {